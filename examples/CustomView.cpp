@@ -1,16 +1,74 @@
 #include <iostream>
 #include <boost/stl_interfaces/iterator_interface.hpp>
 #include <Eigen/Dense>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cassert>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
 #include <iterator>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
 // https://mariusbancila.ro/blog/2020/06/06/a-custom-cpp20-range-view/
 // https://stackoverflow.com/questions/58029724/create-ranges-custom-view-functions-operator-and-operator
 // https://hannes.hauswedell.net/post/2018/04/11/view1/
 
-template <typename Rng>
+// Maps of padded layouts whose records are a multiple of 16 bytes
+// (e.g. xyzw floats) are declared aligned, so Eigen can use aligned
+// SIMD loads. The data has to start at a 16 byte boundary then.
+template <int Stride, typename Scalar>
+inline constexpr int matrix_map_options_v =
+    (Stride * sizeof(Scalar)) % 16 == 0 ? Eigen::Aligned16 : Eigen::Unaligned;
+
+// Point type of a range of scalars: a writable map for mutable ranges, a
+// read-only map for const ones.
+template <typename Rng, int Rows = 3, typename Scalar = float,
+    int MapOptions = Eigen::Unaligned>
+using matrix_point_t = std::conditional_t<
+    std::is_const_v<
+        std::remove_reference_t<std::ranges::range_reference_t<Rng>>>,
+    Eigen::Map<const Eigen::Matrix<Scalar, Rows, 1>, MapOptions>,
+    Eigen::Map<Eigen::Matrix<Scalar, Rows, 1>, MapOptions>>;
+
+// Interprets a range of scalars as points of Rows components, one
+// point every Stride scalars. Stride > Rows skips padding or other
+// attributes, e.g. Rows = 3, Stride = 6 for xyz + rgb records.
+//
+// Every dereference yields a map over distinct scalars, so writes
+// through different iterators never touch the same memory and the
+// iterator can be used with the parallel algorithms
+// (std::execution::par_unseq).
+template <typename Rng, int Rows = 3, int Stride = Rows,
+    typename Scalar = std::remove_cv_t<std::ranges::range_value_t<Rng>>,
+    int MapOptions = matrix_map_options_v<Stride, Scalar>>
 struct matrix_iterator
-    : boost::stl_interfaces::proxy_iterator_interface<matrix_iterator<Rng>,
-          std::random_access_iterator_tag, Eigen::Map<Eigen::Vector3f>>
+    : boost::stl_interfaces::proxy_iterator_interface<
+          matrix_iterator<Rng, Rows, Stride, Scalar, MapOptions>,
+          std::random_access_iterator_tag,
+          matrix_point_t<Rng, Rows, Scalar, MapOptions>>
 {
+    static_assert(Rows > 0 && Stride >= Rows, "a point has to fit its stride");
+    static_assert(
+        std::is_same_v<std::remove_cv_t<std::ranges::range_value_t<Rng>>,
+            Scalar>,
+        "Scalar has to be the value type of the range");
+
+    using point_type = matrix_point_t<Rng, Rows, Scalar, MapOptions>;
+
     constexpr matrix_iterator() noexcept
         : m_iter(nullptr)
     {
@@ -21,27 +79,32 @@ struct matrix_iterator
     {
     }
 
-    Eigen::Map<Eigen::Vector3f> operator*() const noexcept
+    point_type operator*() const noexcept
     {
-        return Eigen::Map<Eigen::Vector3f>(&(*m_iter));
+        return point_type(&(*m_iter));
     }
     constexpr matrix_iterator& operator+=(std::ptrdiff_t i) noexcept
     {
-        m_iter += i * 3;
+        m_iter += i * Stride;
         return *this;
     }
     constexpr auto operator-(matrix_iterator other) const noexcept
     {
-        return (m_iter - other.m_iter) / 3;
+        return (m_iter - other.m_iter) / Stride;
     }
 
 private:
     std::ranges::iterator_t<Rng> m_iter;
 };
 
-template <typename Rng>
-struct matrix_view : public std::ranges::view_interface<matrix_view<Rng>>
+template <typename Rng, int Rows = 3, int Stride = Rows,
+    typename Scalar = std::remove_cv_t<std::ranges::range_value_t<Rng>>,
+    int MapOptions = matrix_map_options_v<Stride, Scalar>>
+struct matrix_view : public std::ranges::view_interface<
+                         matrix_view<Rng, Rows, Stride, Scalar, MapOptions>>
 {
+    using iterator = matrix_iterator<Rng, Rows, Stride, Scalar, MapOptions>;
+
     matrix_view() = default;
     matrix_view(const matrix_view&) = default;
     matrix_view(matrix_view&&) = default;
@@ -51,30 +114,43 @@ struct matrix_view : public std::ranges::view_interface<matrix_view<Rng>>
     matrix_view(Rng rng)
         : m_rng{rng}
     {
+        if constexpr (MapOptions != Eigen::Unaligned &&
+                      std::ranges::contiguous_range<Rng>)
+        {
+            assert(reinterpret_cast<std::uintptr_t>(std::ranges::data(m_rng)) %
+                       16 ==
+                   0);
+        }
     }
 
     auto begin() const
     {
-        return matrix_iterator<Rng>{std::begin(m_rng)};
+        return iterator{std::begin(m_rng)};
     }
+    // A trailing partial record is ignored.
     auto end() const
     {
-        return matrix_iterator<Rng>{std::end(m_rng)};
+        const auto size = std::ranges::distance(m_rng);
+        return iterator{std::begin(m_rng) + size / Stride * Stride};
     }
 
 private:
+    // Like std::ranges::ref_view, a const view still refers to mutable
+    // elements; a view over a const range yields read-only points.
     Rng m_rng;
 };
 
 template <class R>
 matrix_view(R&& base)->matrix_view<std::ranges::views::all_t<R>>;
 
+template <int Rows = 3, int Stride = Rows>
 struct matrix_fn
 {
     template <typename Rng>
     auto operator()(Rng&& rng) const
     {
-        return matrix_view{std::forward<Rng>(rng)};
+        return matrix_view<std::ranges::views::all_t<Rng>, Rows, Stride>{
+            std::forward<Rng>(rng)};
     }
 
     template <typename Rng>
@@ -102,9 +178,686 @@ struct matrix_fn
 namespace views
 {
 constexpr matrix_fn matrix;
+
+// Points of Rows components every Stride scalars, e.g.
+// views::matrix_as<3, 4> for xyzw or views::matrix_as<3, 6> for xyz+rgb.
+template <int Rows, int Stride = Rows>
+constexpr matrix_fn<Rows, Stride> matrix_as;
+} // namespace views
+
+// Iterates a contiguous range of interleaved points in blocks of N
+// points. Every block is a 3xN matrix with compile time dimensions, so
+// Eigen can vectorize across points, e.g. block = rotation * block. The
+// last size % N points do not form a full block and are available
+// through tail(). Pass Eigen::Aligned16/32 as MapOptions if the data is
+// aligned accordingly and 3 * N floats are a multiple of that alignment
+// (N a multiple of 8 for 32 bytes); every block is aligned then.
+template <int N, int MapOptions = Eigen::Unaligned>
+struct matrix_chunk_iterator
+    : boost::stl_interfaces::proxy_iterator_interface<
+          matrix_chunk_iterator<N, MapOptions>,
+          std::random_access_iterator_tag,
+          Eigen::Map<Eigen::Matrix<float, 3, N>, MapOptions>>
+{
+    static constexpr std::ptrdiff_t s_stride = 3 * N;
+
+    constexpr matrix_chunk_iterator() noexcept
+        : m_data(nullptr)
+    {
+    }
+
+    constexpr matrix_chunk_iterator(float* data) noexcept
+        : m_data(data)
+    {
+    }
+
+    Eigen::Map<Eigen::Matrix<float, 3, N>, MapOptions> operator*()
+        const noexcept
+    {
+        return Eigen::Map<Eigen::Matrix<float, 3, N>, MapOptions>(m_data);
+    }
+    constexpr matrix_chunk_iterator& operator+=(std::ptrdiff_t i) noexcept
+    {
+        m_data += i * s_stride;
+        return *this;
+    }
+    constexpr auto operator-(matrix_chunk_iterator other) const noexcept
+    {
+        return (m_data - other.m_data) / s_stride;
+    }
+
+private:
+    float* m_data;
+};
+
+template <typename Rng, int N, int MapOptions = Eigen::Unaligned>
+struct matrix_chunk_view
+    : public std::ranges::view_interface<matrix_chunk_view<Rng, N, MapOptions>>
+{
+    static_assert(N > 0, "N has to be positive");
+    static_assert(std::ranges::contiguous_range<Rng>,
+        "matrix_chunks needs contiguous storage");
+
+    matrix_chunk_view() = default;
+
+    matrix_chunk_view(Rng rng)
+        : m_rng{rng}
+    {
+    }
+
+    auto begin() const
+    {
+        return matrix_chunk_iterator<N, MapOptions>{data()};
+    }
+    auto end() const
+    {
+        return matrix_chunk_iterator<N, MapOptions>{
+            data() + blocks() * 3 * N};
+    }
+
+    // The points behind the last full block.
+    Eigen::Map<Eigen::Matrix3Xf> tail() const
+    {
+        return Eigen::Map<Eigen::Matrix3Xf>(
+            data() + blocks() * 3 * N, 3, points() % N);
+    }
+
+private:
+    float* data() const
+    {
+        return std::ranges::data(const_cast<Rng&>(m_rng));
+    }
+    std::ptrdiff_t points() const
+    {
+        return std::ranges::ssize(m_rng) / 3;
+    }
+    std::ptrdiff_t blocks() const
+    {
+        return points() / N;
+    }
+
+    Rng m_rng;
+};
+
+template <int N, int MapOptions = Eigen::Unaligned>
+struct matrix_chunks_fn
+{
+    template <typename Rng>
+    auto operator()(Rng&& rng) const
+    {
+        return matrix_chunk_view<std::ranges::views::all_t<Rng>, N,
+            MapOptions>{std::forward<Rng>(rng)};
+    }
+
+    template <typename Rng>
+    friend auto operator|(Rng&& rng, const matrix_chunks_fn& c)
+        -> decltype(c(std::forward<Rng>(rng)))
+    {
+        return c(std::forward<Rng>(rng));
+    }
+};
+
+namespace views
+{
+template <int N, int MapOptions = Eigen::Unaligned>
+constexpr matrix_chunks_fn<N, MapOptions> matrix_chunks;
+}
+
+// Random access view over the points of a matrix_view selected by an
+// index list. The indices are shared, so copying the view is cheap.
+template <typename Rng>
+struct matrix_compact_iterator
+    : boost::stl_interfaces::proxy_iterator_interface<
+          matrix_compact_iterator<Rng>, std::random_access_iterator_tag,
+          matrix_point_t<Rng>>
+{
+    constexpr matrix_compact_iterator() noexcept = default;
+
+    constexpr matrix_compact_iterator(
+        matrix_iterator<Rng> base, const std::size_t* index) noexcept
+        : m_base(base)
+        , m_index(index)
+    {
+    }
+
+    matrix_point_t<Rng> operator*() const noexcept
+    {
+        return *(m_base + static_cast<std::ptrdiff_t>(*m_index));
+    }
+    constexpr matrix_compact_iterator& operator+=(std::ptrdiff_t i) noexcept
+    {
+        m_index += i;
+        return *this;
+    }
+    constexpr auto operator-(matrix_compact_iterator other) const noexcept
+    {
+        return m_index - other.m_index;
+    }
+
+private:
+    matrix_iterator<Rng> m_base;
+    const std::size_t* m_index = nullptr;
+};
+
+template <typename Rng>
+struct matrix_compact_view
+    : public std::ranges::view_interface<matrix_compact_view<Rng>>
+{
+    matrix_compact_view() = default;
+
+    matrix_compact_view(matrix_view<Rng> base,
+        std::shared_ptr<const std::vector<std::size_t>> indices)
+        : m_base{std::move(base)}
+        , m_indices{std::move(indices)}
+    {
+    }
+
+    auto begin() const
+    {
+        return matrix_compact_iterator<Rng>{
+            m_base.begin(), m_indices->data()};
+    }
+    auto end() const
+    {
+        return matrix_compact_iterator<Rng>{
+            m_base.begin(), m_indices->data() + m_indices->size()};
+    }
+
+    // Positions of the surviving points in the underlying matrix_view.
+    const std::vector<std::size_t>& indices() const noexcept
+    {
+        return *m_indices;
+    }
+
+private:
+    matrix_view<Rng> m_base;
+    std::shared_ptr<const std::vector<std::size_t>> m_indices;
+};
+
+// Filters the points of a contiguous range of floats once, up front.
+// Unlike std::views::filter the result is random access and sized and
+// the predicate is not evaluated again on later passes. The predicate
+// is called with blocks of points as 3xN Eigen matrices and returns one
+// boolean per column, e.g.
+//
+//   [](const auto& p) { return (p.array() != -1.0f).colwise().all(); }
+//
+// so it is evaluated as a vectorized Eigen expression. The index list
+// is written without branches.
+template <typename Pred>
+struct matrix_compact_fn
+{
+    Pred pred;
+
+    template <typename Rng>
+    auto operator()(Rng&& rng) const
+    {
+        static_assert(std::ranges::contiguous_range<Rng>,
+            "matrix_compact needs contiguous storage");
+        using View = std::ranges::views::all_t<Rng>;
+        constexpr Eigen::Index block = 256;
+
+        View base{std::forward<Rng>(rng)};
+        const auto n = static_cast<Eigen::Index>(std::ranges::size(base) / 3);
+        const Eigen::Map<const Eigen::Matrix3Xf> points(
+            std::ranges::data(base), 3, n);
+        auto indices = std::make_shared<std::vector<std::size_t>>(n);
+        Eigen::Array<bool, 1, Eigen::Dynamic> keep(block);
+        std::size_t out = 0;
+        for (Eigen::Index i = 0; i < n; i += block)
+        {
+            const auto m = std::min(block, n - i);
+            keep.head(m) = pred(points.middleCols(i, m));
+            for (Eigen::Index j = 0; j < m; ++j)
+            {
+                (*indices)[out] = static_cast<std::size_t>(i + j);
+                out += keep(j);
+            }
+        }
+        indices->resize(out);
+        return matrix_compact_view<View>{
+            matrix_view<View>{std::move(base)}, std::move(indices)};
+    }
+
+    template <typename Rng>
+    friend auto operator|(Rng&& rng, const matrix_compact_fn& c)
+        -> decltype(c(std::forward<Rng>(rng)))
+    {
+        return c(std::forward<Rng>(rng));
+    }
+};
+
+namespace views
+{
+template <typename Pred>
+auto matrix_compact(Pred pred)
+{
+    return matrix_compact_fn<Pred>{std::move(pred)};
+}
+} // namespace views
+
+// Point cloud file mapped into memory, usable as a contiguous range of
+// floats, e.g. mapped_cloud{path} | views::matrix. Pages are read on
+// first access, so processing starts without reading and copying the
+// whole file. The file is either raw float32 x, y, z triples or starts
+// with a 16 byte header: the magic "PCXYZF32" followed by the number of
+// points as a native endian uint64.
+class mapped_cloud
+{
+public:
+    enum class mode
+    {
+        // Writes through the points stay in memory (copy on write).
+        copy_on_write,
+        // Writes through the points end up in the file.
+        shared
+    };
+
+    static constexpr char s_magic[8] = {'P', 'C', 'X', 'Y', 'Z', 'F', '3', '2'};
+    static constexpr std::size_t s_headerSize = 16;
+
+    explicit mapped_cloud(
+        const std::filesystem::path& path, mode m = mode::copy_on_write)
+    {
+        const int fd =
+            ::open(path.c_str(), m == mode::shared ? O_RDWR : O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            const auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        m_length = static_cast<std::size_t>(info.st_size);
+        // An empty file cannot be mapped and stays unmapped.
+        if (m_length > 0)
+        {
+            m_mapping = ::mmap(nullptr, m_length, PROT_READ | PROT_WRITE,
+                m == mode::shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+            if (m_mapping == MAP_FAILED)
+            {
+                const auto error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), path);
+            }
+        }
+        ::close(fd);
+        if (m_length > 0)
+        {
+            // Read ahead aggressively and drop pages behind. Transparent
+            // huge pages are only a hint; most file systems ignore it
+            // for file mappings.
+            ::madvise(m_mapping, m_length, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+            ::madvise(m_mapping, m_length, MADV_HUGEPAGE);
+#endif
+        }
+        parse(path);
+    }
+
+    mapped_cloud(const mapped_cloud&) = delete;
+    mapped_cloud& operator=(const mapped_cloud&) = delete;
+
+    mapped_cloud(mapped_cloud&& other) noexcept
+        : m_mapping{std::exchange(other.m_mapping, MAP_FAILED)}
+        , m_length{std::exchange(other.m_length, 0)}
+        , m_data{std::exchange(other.m_data, nullptr)}
+        , m_size{std::exchange(other.m_size, 0)}
+    {
+    }
+
+    mapped_cloud& operator=(mapped_cloud&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            m_mapping = std::exchange(other.m_mapping, MAP_FAILED);
+            m_length = std::exchange(other.m_length, 0);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~mapped_cloud()
+    {
+        unmap();
+    }
+
+    // Number of floats, i.e. 3 * number of points.
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+    float* data() noexcept
+    {
+        return m_data;
+    }
+    const float* data() const noexcept
+    {
+        return m_data;
+    }
+    float* begin() noexcept
+    {
+        return m_data;
+    }
+    float* end() noexcept
+    {
+        return m_data + m_size;
+    }
+    const float* begin() const noexcept
+    {
+        return m_data;
+    }
+    const float* end() const noexcept
+    {
+        return m_data + m_size;
+    }
+
+    // Writes points in the header format.
+    static void write(
+        const std::filesystem::path& path, std::span<const float> points)
+    {
+        std::ofstream file(path, std::ios::binary);
+        const std::uint64_t count = points.size() / 3;
+        file.write(s_magic, sizeof(s_magic));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(points.data()),
+            static_cast<std::streamsize>(count * 3 * sizeof(float)));
+        if (!file)
+        {
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+    }
+
+private:
+    void parse(const std::filesystem::path& path)
+    {
+        auto* bytes = static_cast<char*>(m_mapping);
+        std::size_t offset = 0;
+        std::size_t points = m_length / (3 * sizeof(float));
+        if (m_length >= s_headerSize &&
+            std::memcmp(bytes, s_magic, sizeof(s_magic)) == 0)
+        {
+            std::uint64_t count;
+            std::memcpy(&count, bytes + sizeof(s_magic), sizeof(count));
+            offset = s_headerSize;
+            points = (m_length - offset) / (3 * sizeof(float));
+            if (count > points)
+            {
+                unmap();
+                throw std::runtime_error(
+                    path.string() + ": truncated point cloud");
+            }
+            points = count;
+        }
+        m_data = m_length > 0 ? reinterpret_cast<float*>(bytes + offset) :
+                                nullptr;
+        m_size = points * 3;
+    }
+
+    void unmap() noexcept
+    {
+        if (m_mapping != MAP_FAILED && m_length > 0)
+        {
+            ::munmap(m_mapping, m_length);
+        }
+        m_mapping = MAP_FAILED;
+    }
+
+    void* m_mapping = MAP_FAILED;
+    std::size_t m_length = 0;
+    float* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+// Bulk operations on a range of points (e.g. a matrix_view) using the
+// parallel algorithms. Pass std::execution::seq to run them
+// sequentially.
+namespace parallel
+{
+// Plain Eigen vector type of the points of a view.
+template <typename View>
+using point_t = typename std::remove_cvref_t<
+    std::ranges::range_reference_t<const View>>::PlainObject;
+
+template <typename Policy, typename View>
+point_t<View> centroid(Policy&& policy, const View& view)
+{
+    using Point = point_t<View>;
+    // The sum of millions of floats loses too many digits, and how many
+    // depends on the order of the reduction, i.e. on the policy.
+    using Sum = Eigen::Matrix<double, Point::RowsAtCompileTime, 1>;
+    const auto n = std::ranges::distance(view);
+    if (n == 0)
+    {
+        return Point::Zero();
+    }
+    // Reduce into concrete vectors; std::plus<> would return an Eigen
+    // expression referring to temporaries.
+    const Sum sum = std::transform_reduce(std::forward<Policy>(policy),
+        view.begin(), view.end(), Sum(Sum::Zero()),
+        [](const Sum& a, const Sum& b) -> Sum { return a + b; },
+        [](const auto& p) -> Sum { return p.template cast<double>(); });
+    return (sum / static_cast<double>(n))
+        .template cast<typename Point::Scalar>();
 }
 
-int main()
+template <typename Policy, typename View>
+auto bounding_box(Policy&& policy, const View& view)
+{
+    using Point = point_t<View>;
+    using Box =
+        Eigen::AlignedBox<typename Point::Scalar, Point::RowsAtCompileTime>;
+    return std::transform_reduce(std::forward<Policy>(policy), view.begin(),
+        view.end(), Box{},
+        [](Box a, const Box& b) { return a.extend(b); },
+        [](const auto& p) { return Box(p, p); });
+}
+
+// p = transform * p for every point, in place.
+template <typename Policy, typename View, typename Scalar, int Dim, int Mode,
+    int Options>
+void transform(Policy&& policy, const View& view,
+    const Eigen::Transform<Scalar, Dim, Mode, Options>& transform)
+{
+    const Eigen::Matrix<Scalar, Dim, Dim> linear = transform.linear();
+    const Eigen::Matrix<Scalar, Dim, 1> translation = transform.translation();
+    std::for_each(std::forward<Policy>(policy), view.begin(), view.end(),
+        [&](auto p) { p = linear * p + translation; });
+}
+} // namespace parallel
+
+template <typename F>
+double measure(F&& f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Compares sequential and parallel execution of the bulk operations.
+// The speedup is bounded by the number of cores and the memory
+// bandwidth.
+void benchmark_parallel(std::size_t points)
+{
+    std::vector<float> cloud(3 * points);
+    const auto view = cloud | views::matrix;
+    const Eigen::Affine3f transform(
+        Eigen::AngleAxisf(0.1f, Eigen::Vector3f::UnitY()));
+
+    const auto run = [&](const char* name, auto policy) {
+        for (std::size_t i = 0; i < cloud.size(); ++i)
+        {
+            cloud[i] = static_cast<float>(i % 1000);
+        }
+        Eigen::Vector3f c;
+        Eigen::AlignedBox3f box;
+        const auto tc = measure([&] { c = parallel::centroid(policy, view); });
+        const auto tb =
+            measure([&] { box = parallel::bounding_box(policy, view); });
+        const auto tt =
+            measure([&] { parallel::transform(policy, view, transform); });
+        std::cout << name << ": centroid " << tc << " ms, bounding box " << tb
+                  << " ms, transform " << tt << " ms (" << c.transpose()
+                  << " / " << box.sizes().transpose() << ")" << std::endl;
+    };
+    std::cout << points << " points, " << std::thread::hardware_concurrency()
+              << " threads" << std::endl;
+    run("seq", std::execution::seq);
+    run("par_unseq", std::execution::par_unseq);
+}
+
+// Structure of arrays companion of matrix_view: the x, y and z
+// components are stored in separate contiguous arrays. Bulk operations
+// work on whole columns as Eigen array expressions, which Eigen
+// evaluates with packet (SIMD) instructions, e.g. 8 floats per
+// instruction with AVX, instead of one Eigen::Map per point.
+struct soa_view
+{
+    std::span<float> x;
+    std::span<float> y;
+    std::span<float> z;
+
+    std::size_t size() const noexcept
+    {
+        return x.size();
+    }
+
+    auto xs() const noexcept
+    {
+        return Eigen::Map<Eigen::ArrayXf>(x.data(), x.size());
+    }
+    auto ys() const noexcept
+    {
+        return Eigen::Map<Eigen::ArrayXf>(y.data(), y.size());
+    }
+    auto zs() const noexcept
+    {
+        return Eigen::Map<Eigen::ArrayXf>(z.data(), z.size());
+    }
+};
+
+// Owning storage for soa_view.
+struct soa_points
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    soa_view view() noexcept
+    {
+        return {x, y, z};
+    }
+
+    // Keeps the first n points.
+    void resize(std::size_t n)
+    {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+    }
+};
+
+// De-interleaves a range of points, e.g. a matrix_view.
+template <typename Rng>
+soa_points to_soa(Rng&& rng)
+{
+    soa_points points;
+    const auto n = static_cast<std::size_t>(std::ranges::distance(rng));
+    points.x.reserve(n);
+    points.y.reserve(n);
+    points.z.reserve(n);
+    for (auto p : rng)
+    {
+        points.x.push_back(p.x());
+        points.y.push_back(p.y());
+        points.z.push_back(p.z());
+    }
+    return points;
+}
+
+namespace soa
+{
+// Euclidean norm of every point.
+inline void norms(const soa_view& v, std::span<float> out)
+{
+    Eigen::Map<Eigen::ArrayXf>(out.data(), out.size()) =
+        (v.xs().square() + v.ys().square() + v.zs().square()).sqrt();
+}
+
+inline Eigen::Vector3f sum(const soa_view& v)
+{
+    return {v.xs().sum(), v.ys().sum(), v.zs().sum()};
+}
+
+inline Eigen::Vector3f centroid(const soa_view& v)
+{
+    return v.size() ? Eigen::Vector3f(sum(v) / static_cast<float>(v.size())) :
+                      Eigen::Vector3f::Zero();
+}
+
+// p = rotation * p + translation for every point, in place. Works on
+// blocks so the temporaries stay in registers/L1 and nothing is
+// allocated.
+inline void transform(const soa_view& v, const Eigen::Matrix3f& rotation,
+    const Eigen::Vector3f& translation)
+{
+    constexpr Eigen::Index block = 256;
+    const auto n = static_cast<Eigen::Index>(v.size());
+    Eigen::Array<float, block, 1> x, y;
+    for (Eigen::Index i = 0; i < n; i += block)
+    {
+        const auto m = std::min(block, n - i);
+        auto xs = v.xs().segment(i, m);
+        auto ys = v.ys().segment(i, m);
+        auto zs = v.zs().segment(i, m);
+        x.head(m) = xs;
+        y.head(m) = ys;
+        xs = rotation(0, 0) * x.head(m) + rotation(0, 1) * y.head(m) +
+             rotation(0, 2) * zs + translation(0);
+        ys = rotation(1, 0) * x.head(m) + rotation(1, 1) * y.head(m) +
+             rotation(1, 2) * zs + translation(1);
+        zs = rotation(2, 0) * x.head(m) + rotation(2, 1) * y.head(m) +
+             rotation(2, 2) * zs + translation(2);
+    }
+}
+
+// Keeps the points for which pred(xs, ys, zs) is true and moves them to
+// the front. pred gets the columns as Eigen arrays and has to return a
+// boolean array expression, so the predicate itself is vectorized. The
+// compaction is branch free. Returns the number of remaining points.
+template <typename Pred>
+std::size_t filter(const soa_view& v, Pred pred)
+{
+    constexpr Eigen::Index block = 256;
+    const auto n = static_cast<Eigen::Index>(v.size());
+    Eigen::Array<bool, block, 1> keep;
+    std::size_t out = 0;
+    for (Eigen::Index i = 0; i < n; i += block)
+    {
+        const auto m = std::min(block, n - i);
+        keep.head(m) = pred(v.xs().segment(i, m), v.ys().segment(i, m),
+            v.zs().segment(i, m));
+        for (Eigen::Index j = 0; j < m; ++j)
+        {
+            v.x[out] = v.x[i + j];
+            v.y[out] = v.y[i + j];
+            v.z[out] = v.z[i + j];
+            out += keep(j);
+        }
+    }
+    return out;
+}
+} // namespace soa
+
+int main(int argc, char** argv)
 {
     std::vector<float> bla{1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, -1.0f, -1.0f,
         -1.0f, 9.0f, 9.0f, 9.0f};
@@ -131,4 +884,106 @@ int main()
     {
         std::cout << Eigen::Transpose(i) << std::endl;
     }
+
+    // Same filter evaluated once; the result keeps random access.
+    auto compact = bla | views::matrix_compact([](const auto& p) {
+        return (p.array() != -1.0f).colwise().all();
+    });
+    static_assert(std::ranges::random_access_range<decltype(compact)>);
+    static_assert(std::ranges::sized_range<decltype(compact)>);
+    std::cout << compact.size() << " points, last "
+              << compact[compact.size() - 1].transpose() << std::endl;
+
+    // Same filter on the structure of arrays layout, evaluated on whole
+    // columns.
+    auto points = to_soa(bla | views::matrix);
+    points.resize(soa::filter(points.view(), [](auto x, auto y, auto z) {
+        return x != -1.0f && y != -1.0f && z != -1.0f;
+    }));
+    soa::transform(points.view(),
+        Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitZ()).toRotationMatrix(),
+        Eigen::Vector3f(1.0f, 0.0f, 0.0f));
+    std::vector<float> lengths(points.x.size());
+    soa::norms(points.view(), lengths);
+    std::cout << "centroid " << soa::centroid(points.view()).transpose()
+              << std::endl;
+    for (auto l : lengths)
+    {
+        std::cout << "norm " << l << std::endl;
+    }
+
+    // Rotate 20 points: two 3x8 blocks and a tail of 4 points.
+    std::vector<float> cloud(3 * 20);
+    for (std::size_t i = 0; i < cloud.size(); ++i)
+    {
+        cloud[i] = static_cast<float>(i);
+    }
+    const Eigen::Matrix3f rotation =
+        Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+    auto chunks = cloud | views::matrix_chunks<8>;
+    for (auto block : chunks)
+    {
+        block = rotation * block;
+    }
+    chunks.tail() = rotation * chunks.tail();
+    std::cout << "blocks " << std::ranges::size(chunks) << ", tail "
+              << chunks.tail().cols() << std::endl;
+    for (auto p : cloud | views::matrix)
+    {
+        std::cout << Eigen::Transpose(p) << std::endl;
+    }
+
+    // Read-only points for const data.
+    const std::vector<float> fixed{1, 2, 3, 4, 5, 6};
+    std::cout << "centroid "
+              << parallel::centroid(std::execution::par_unseq,
+                     fixed | views::matrix)
+                     .transpose()
+              << std::endl;
+
+    // Other layouts: xyz + rgb records, xyzw padded to 16 bytes (aligned
+    // maps) and double precision.
+    const std::vector<float> colored{1, 2, 3, 255, 0, 0, 4, 5, 6, 0, 255, 0};
+    for (auto p : colored | views::matrix_as<3, 6>)
+    {
+        std::cout << "xyz " << p.transpose() << std::endl;
+    }
+    std::vector<float, Eigen::aligned_allocator<float>> padded{
+        1, 2, 3, 0, 4, 5, 6, 0};
+    static_assert(
+        std::is_same_v<decltype(*(padded | views::matrix_as<4>).begin()),
+            Eigen::Map<Eigen::Vector4f, Eigen::Aligned16>>);
+    for (auto p : padded | views::matrix_as<4>)
+    {
+        p = 2.0f * p;
+    }
+    std::cout << "xyzw " << (padded | views::matrix_as<4>)[1].transpose()
+              << std::endl;
+    std::vector<double> precise{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+    std::cout << "double "
+              << parallel::centroid(std::execution::seq,
+                     precise | views::matrix_as<3>)
+                     .transpose()
+              << std::endl;
+
+    // The same views over a memory mapped file.
+    const auto path =
+        std::filesystem::temp_directory_path() / "custom_view_cloud.bin";
+    mapped_cloud::write(path, cloud);
+    {
+        mapped_cloud mapped{path};
+        std::cout << "mapped " << std::ranges::size(mapped | views::matrix)
+                  << " points, centroid "
+                  << parallel::centroid(std::execution::par_unseq,
+                         mapped | views::matrix)
+                         .transpose()
+                  << std::endl;
+    }
+    std::filesystem::remove(path);
+
+    // Takes long in an unoptimized build.
+    if (argc > 1 && std::string_view{argv[1]} == "--benchmark")
+    {
+        benchmark_parallel(10'000'000);
+    }
 }
@@ -0,0 +1,185 @@
+// Type erasure without per object heap allocations, see the Type
+// Erasure idioms in cppknowhow.org.
+
+#include "utility/any_of.hpp"
+#include "utility/erased_ref.hpp"
+#include "utility/inplace_function.hpp"
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Counts the allocations of the whole program. Not inlined, otherwise
+// GCC mistakes the malloc/free pairs for mismatched new/delete.
+static std::size_t s_allocations = 0;
+
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+    ++s_allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+
+struct Printable
+{
+    void (*print)(const void* self, std::ostream& os);
+
+    template <typename T>
+    static constexpr Printable vtable_for = {
+        [](const void* self, std::ostream& os) {
+            os << *static_cast<const T*>(self);
+        }};
+};
+
+using UniquePrintable = basic_any_of<Printable>;
+
+std::ostream& operator<<(std::ostream& os, const UniquePrintable& p)
+{
+    p.call<&Printable::print>(os);
+    return os;
+}
+
+// Move-only
+struct Handle
+{
+    std::unique_ptr<int> value;
+
+    friend std::ostream& operator<<(std::ostream& os, const Handle& h)
+    {
+        return os << "Handle(" << *h.value << ")";
+    }
+};
+
+// Too large for the small buffer
+struct Matrix
+{
+    std::array<double, 16> values{};
+
+    friend std::ostream& operator<<(std::ostream& os, const Matrix& m)
+    {
+        return os << "Matrix(" << m.values[0] << ", ...)";
+    }
+};
+
+void printit(UniquePrintable p)
+{
+    std::cout << "The printable thing was: " << p << " ("
+              << (p.isInline() ? "inline" : "heap") << ")." << std::endl;
+}
+
+// Methods for erased_ref
+struct print
+{
+    using signature = void(std::ostream&);
+
+    template <typename Self>
+    static void call(const Self& self, std::ostream& os)
+    {
+        os << self;
+    }
+};
+
+struct size_in_bytes
+{
+    using signature = std::size_t();
+
+    template <typename Self>
+    static std::size_t call(const Self&)
+    {
+        return sizeof(Self);
+    }
+};
+
+using PrintableRef = erased_ref<print, size_in_bytes>;
+
+static_assert(std::is_trivially_copyable_v<PrintableRef>);
+static_assert(std::is_trivially_copyable_v<function_ref<int(int)>>);
+static_assert(sizeof(function_ref<int(int)>) == 2 * sizeof(void*));
+static_assert(sizeof(PrintableRef) == 3 * sizeof(void*));
+
+void printref(PrintableRef p)
+{
+    std::cout << "The printable thing was: ";
+    p(print{}, std::cout);
+    std::cout << " (" << p.call<size_in_bytes>() << " bytes)." << std::endl;
+}
+
+int twice(int i)
+{
+    return 2 * i;
+}
+
+int apply(function_ref<int(int)> f, int value)
+{
+    return f(value);
+}
+
+int main()
+{
+    const std::string text = "hello world, longer than the SSO buffer";
+    auto handle = Handle{std::make_unique<int>(7)};
+
+    const auto before = s_allocations;
+    printit(42);
+    printit("hello world");
+    printit(3.5);
+    printit(text);
+    printit(std::move(handle));
+    std::cout << "allocations: " << s_allocations - before
+              << " (one for the string copy)" << std::endl;
+
+    const auto beforeMatrix = s_allocations;
+    printit(Matrix{});
+    std::cout << "allocations: " << s_allocations - beforeMatrix << std::endl;
+
+    const auto beforeRef = s_allocations;
+    printref(42);
+    printref(text);
+    printref(Matrix{});
+    const int offset = 3;
+    std::cout << apply(twice, 4) << " "
+              << apply([offset](int i) { return i + offset; }, 4) << std::endl;
+    std::cout << "allocations: " << s_allocations - beforeRef << std::endl;
+
+    // A queue of jobs which own their (move-only) state. The vector is
+    // reserved up front, so only the jobs themselves could allocate.
+    std::vector<inplace_function<void()>> jobs;
+    jobs.reserve(3);
+    auto job = Handle{std::make_unique<int>(11)};
+    const auto beforeJobs = s_allocations;
+    jobs.emplace_back([job = std::move(job)] { std::cout << job << std::endl; });
+    jobs.emplace_back([&text] { std::cout << text.size() << std::endl; });
+    jobs.emplace_back(
+        [values = std::array<int, 4>{1, 2, 3, 4}] { std::cout << values[3] << std::endl; });
+    // Does not compile, a Matrix does not fit into 32 bytes:
+    // jobs.emplace_back([m = Matrix{}] { std::cout << m << std::endl; });
+    for (auto& j : jobs)
+    {
+        j();
+    }
+    std::cout << "allocations: " << s_allocations - beforeJobs << std::endl;
+
+    const auto beforeLarge = s_allocations;
+    move_only_function<void()> large = [m = Matrix{}] { std::cout << m << std::endl; };
+    auto moved = std::move(large);
+    moved();
+    std::cout << (moved.isInline() ? "inline" : "heap")
+              << ", allocations: " << s_allocations - beforeLarge << std::endl;
+}
@@ -10,7 +10,8 @@
 #include <optional>
 #include <deque>
 #include <memory>
-#include <functional>
+#include "../utility/erased_ref.hpp"
+#include "../utility/inplace_function.hpp"
 
 auto dbg = [](const char* s) { std::cout << "Function " << s << " called.\n"; };
 
@@ -205,8 +206,9 @@ struct Batcher
     }
 
     Executor& m_executor;
-    std::function<std::vector<R>(std::vector<T>)> m_op;
-    std::function<bool(const std::vector<T>&)> m_should_execute_op;
+    // Not owned, the operation has to outlive the batcher.
+    function_ref<std::vector<R>(std::vector<T>)> m_op;
+    inplace_function<bool(const std::vector<T>&)> m_should_execute_op;
     std::shared_ptr<Batch> m_current_batch = std::make_shared<Batch>();
 };
 
@@ -6,9 +6,9 @@
 #include <iostream>
 #include <coroutine>
 #include <unordered_map>
-#include <functional>
 #include <memory>
 #include <type_traits>
+#include "../utility/erased_ref.hpp"
 
 auto dbg = [](const char* s) { std::cout << "Function " << s << " called.\n"; };
 
@@ -202,11 +202,13 @@ struct task
 
 struct io
 {
-    std::unordered_map<int, std::function<void(std::string)>> outstanding;
-    void submit(int fd, auto fun)
+    // Non-owning: the callback (usually the awaiter) has to stay alive
+    // until complete() was called for fd.
+    std::unordered_map<int, function_ref<void(std::string)>> outstanding;
+    void submit(int fd, function_ref<void(std::string)> fun)
     {
         DBG;
-        outstanding[fd] = fun;
+        outstanding.insert_or_assign(fd, fun);
     }
 
     void complete(int fd, std::string value)
@@ -217,7 +219,7 @@ struct io
         {
             auto fun = it->second;
             outstanding.erase(it);
-            fun(value);
+            fun(std::move(value));
         }
     }
 };
@@ -227,19 +229,26 @@ struct async_read
     io& context;
     int fd;
     std::string value;
+    std::coroutine_handle<> handle;
     bool await_ready() const
     {
         DBG;
         return false;
     };
 
+    // The awaiter lives in the coroutine frame while suspended, so it
+    // can be the callback itself.
     void await_suspend(std::coroutine_handle<> h)
     {
         DBG;
-        context.submit(fd, [this, h](const std::string& line) {
-            value = line;
-            h.resume();
-        });
+        handle = h;
+        context.submit(fd, *this);
+    }
+
+    void operator()(std::string line)
+    {
+        value = std::move(line);
+        handle.resume();
     }
 
     std::string await_resume()
@@ -7,51 +7,178 @@
 #include <coroutine>
 #include <unordered_map>
 #include <functional>
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
 #include <stdio.h>
 #include <thread>
-#include <queue>
-#include <mutex>
-#include <queue>
-#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <vector>
 
 auto dbg = [](const char* s) { std::cout << "Function " << s << " called.\n"; };
 
 #define DBG dbg(__PRETTY_FUNCTION__)
 
-template <typename T>
+/**
+ * Blocking point for threads waiting on a condition of a lock-free
+ * structure (e.g. "queue not empty"). Waiters announce themselves
+ * before re-checking the condition, so a notifier only touches the
+ * futex (atomic::notify) when somebody actually sleeps.
+ */
+class WaitPoint
+{
+public:
+    /**
+     * Announces a waiter. Returns the epoch which has to be passed to
+     * wait() after the condition was re-checked.
+     */
+    std::uint32_t prepare() noexcept
+    {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Sleeps until notify() is called after prepare() returned epoch.
+     */
+    void wait(std::uint32_t epoch) noexcept
+    {
+        m_epoch.wait(epoch, std::memory_order_acquire);
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Withdraws a waiter whose re-check succeeded.
+     */
+    void cancel() noexcept
+    {
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Wakes one waiter, if any. Has to be called after the state change
+     * the waiters are interested in was published.
+     *
+     * @return true if a waiter was woken up
+     */
+    bool notify() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) == 0)
+        {
+            return false;
+        }
+        m_epoch.fetch_add(1, std::memory_order_release);
+        m_epoch.notify_one();
+        return true;
+    }
+
+    /**
+     * Wakes all waiters unconditionally (e.g. on shutdown).
+     */
+    void notifyAll() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_epoch.fetch_add(1, std::memory_order_release);
+        m_epoch.notify_all();
+    }
+
+private:
+    std::atomic<std::uint32_t> m_waiters = 0;
+    std::atomic<std::uint32_t> m_epoch = 0;
+};
+
+/**
+ * Bounded multi-producer multi-consumer queue after Dmitry Vyukov
+ * (https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue).
+ * Every cell carries a sequence number which tells producers and
+ * consumers whether the cell is free for the current lap. Producers
+ * and consumers only contend on their own position counter. Blocking
+ * is done with atomic wait/notify and only if the queue is empty (or
+ * full for push).
+ *
+ * @tparam T element type
+ * @tparam Capacity number of cells, has to be a power of two
+ */
+template <typename T, std::size_t Capacity = 1024>
 class Queue
 {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity has to be a power of two");
+
 public:
+    Queue() noexcept
+    {
+        for (std::size_t i = 0; i < Capacity; ++i)
+        {
+            m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    Queue(const Queue&) = delete;
+
+    Queue& operator=(const Queue&) = delete;
+
+    ~Queue()
+    {
+        clear();
+    }
+
     /**
-     * Pushes element on queue
+     * Pushes element on queue. Blocks while the queue is full.
      *
      * @param e  the element
      */
     void push(const T& e)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_queue.push(e);
-        lock.unlock();
-        m_cond.notify_one();
+        emplace(e);
     };
 
     void push(T&& e)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_queue.push(std::move(e));
-        lock.unlock();
-        m_cond.notify_one();
+        emplace(std::move(e));
     };
 
     /**
+     * Pushes element on queue if there is a free cell.
+     *
+     * @param e  the element
      *
-     * @return true if queue is empty, false otherwise
+     * @return true if element was pushed, false if queue is full
+     */
+    bool tryPush(T&& e)
+    {
+        if (!tryEmplace(std::move(e)))
+        {
+            return false;
+        }
+        m_notEmpty.notify();
+        return true;
+    }
+
+    /**
+     *
+     * @return true if queue is empty, false otherwise. Only a snapshot if
+     * other threads modify the queue concurrently.
      */
     bool empty() const
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        return m_queue.empty();
+        const auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+        const auto seq = m_buffer[pos & s_mask].sequence.load(
+            std::memory_order_acquire);
+        return static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0;
     }
 
     /**
@@ -61,18 +188,11 @@ public:
      *
      * @param e reference to the first element
      *
-     * @return true if queue is empty, false otherwise
+     * @return true if an element was popped, false if queue is empty
      */
-    bool tryPop(const T& e)
+    bool tryPop(T& e)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_queue.empty())
-        {
-            return false;
-        }
-        e = m_queue.front();
-        m_queue.pop();
-        return true;
+        return tryPopWith([&e](T&& value) { e = std::move(value); });
     }
 
     /**
@@ -85,14 +205,9 @@ public:
      */
     T waitAndPop()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        while (m_queue.empty())
-        {
-            m_cond.wait(lock);
-        }
-        T data = std::move(m_queue.front());
-        m_queue.pop();
-        return data;
+        std::optional<T> data;
+        waitAndPopWith([&data](T&& value) { data.emplace(std::move(value)); });
+        return std::move(*data);
     }
 
     /**
@@ -104,13 +219,7 @@ public:
      */
     void waitAndPop(T& e)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        while (m_queue.empty())
-        {
-            m_cond.wait(lock);
-        }
-        e = m_queue.front();
-        m_queue.pop();
+        waitAndPopWith([&e](T&& value) { e = std::move(value); });
     }
 
     /**
@@ -119,89 +228,299 @@ public:
      */
     void clear()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        std::queue<T>().swap(m_queue);
+        while (tryPopWith([](T&&) {}))
+        {
+        }
     }
 
 private:
-    std::queue<T> m_queue;
-    mutable std::mutex m_mutex;
-    std::condition_variable m_cond;
-};
+    static constexpr std::size_t s_mask = Capacity - 1;
 
-class ThreadRunner
-{
-public:
-    using Func = std::function<void()>;
+    // Keep the position counters apart so producers and consumers do
+    // not invalidate each other's cache lines.
+    static constexpr std::size_t s_cacheLine = 64;
 
-    static ThreadRunner& instance()
+    struct Cell
     {
-        static ThreadRunner runner;
-        return runner;
-    }
+        std::atomic<std::size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
 
-    ThreadRunner()
-        : m_thread([this] { this->run(); })
+        T* data() noexcept
+        {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    // consume is called with the popped element. Unlike tryPop/waitAndPop
+    // with a reference parameter this does not need a default
+    // constructible T.
+    template <typename F>
+    bool tryPopWith(F&& consume)
     {
+        if (!tryDequeue(consume))
+        {
+            return false;
+        }
+        m_notFull.notify();
+        return true;
     }
 
-    ~ThreadRunner()
+    template <typename F>
+    void waitAndPopWith(F&& consume)
     {
-        enqueue([&] { m_done = true; });
-        m_thread.join();
+        while (!tryPopWith(consume))
+        {
+            const auto epoch = m_notEmpty.prepare();
+            if (tryPopWith(consume))
+            {
+                m_notEmpty.cancel();
+                return;
+            }
+            m_notEmpty.wait(epoch);
+        }
     }
 
-    ThreadRunner(const ThreadRunner&) = delete;
-
-    ThreadRunner& operator=(const ThreadRunner&) = delete;
-
-    void enqueue(Func f)
+    template <typename U>
+    void emplace(U&& e)
     {
-        m_queue.push(std::move(f));
+        while (!tryEmplace(std::forward<U>(e)))
+        {
+            const auto epoch = m_notFull.prepare();
+            if (tryEmplace(std::forward<U>(e)))
+            {
+                m_notFull.cancel();
+                break;
+            }
+            m_notFull.wait(epoch);
+        }
+        m_notEmpty.notify();
     }
 
-private:
-    void run()
+    // Only consumes e on success.
+    template <typename U>
+    bool tryEmplace(U&& e)
     {
-        while (!m_done)
+        auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
         {
-            Func f = m_queue.waitAndPop();
-            f();
+            cell = &m_buffer[pos & s_mask];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
         }
+        ::new (static_cast<void*>(cell->storage)) T(std::forward<U>(e));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
     }
 
-    Queue<Func> m_queue;
-
-    bool m_done = false;
+    template <typename F>
+    bool tryDequeue(F& consume)
+    {
+        auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &m_buffer[pos & s_mask];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        T* data = cell->data();
+        consume(std::move(*data));
+        data->~T();
+        cell->sequence.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
 
-    std::thread m_thread;
+    Cell m_buffer[Capacity];
+    alignas(s_cacheLine) std::atomic<std::size_t> m_enqueuePos = 0;
+    alignas(s_cacheLine) std::atomic<std::size_t> m_dequeuePos = 0;
+    alignas(s_cacheLine) WaitPoint m_notEmpty;
+    WaitPoint m_notFull;
 };
 
+/**
+ * Coroutine thread pool. Every worker owns a local queue; handles
+ * enqueued from a worker stay on that worker (good locality for
+ * continuations), handles enqueued from outside go to a global
+ * injection queue. Idle workers steal from the injection queue and
+ * from the other workers before they park. Parked workers are woken in
+ * round-robin order so the load spreads over the pool.
+ */
 class CTP
 {
 public:
     static CTP& instance()
     {
-        static CTP ctp{2};
+        static CTP ctp{static_cast<int>(
+            std::max(2u, std::thread::hardware_concurrency()))};
         return ctp;
     }
 
-    CTP(int thread_count)
+    explicit CTP(int thread_count)
+        : m_workers(static_cast<std::size_t>(std::max(thread_count, 1)))
     {
+        for (std::size_t i = 0; i < m_workers.size(); ++i)
+        {
+            m_workers[i].thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    ~CTP()
+    {
+        m_stop.store(true, std::memory_order_release);
+        for (auto& worker : m_workers)
+        {
+            worker.parked.notifyAll();
+        }
+        for (auto& worker : m_workers)
+        {
+            worker.thread.join();
+        }
     }
 
+    CTP(const CTP&) = delete;
+
+    CTP& operator=(const CTP&) = delete;
+
+    /**
+     * Schedules coroutine to be resumed on one of the pool threads. May
+     * be called from any thread.
+     *
+     * @param coroutine the suspended coroutine
+     */
     void enqueue(std::coroutine_handle<> coroutine)
     {
-        std::cout << "Enqueue" << std::endl;
+        if (s_currentPool != this ||
+            !m_workers[s_currentIndex].queue.tryPush(std::move(coroutine)))
+        {
+            m_injection.push(coroutine);
+        }
+        wakeOne();
     }
 
 private:
-    std::thread m_thread;
+    struct Worker
+    {
+        Queue<std::coroutine_handle<>, 256> queue;
+        WaitPoint parked;
+        std::thread thread;
+    };
+
+    void run(std::size_t index)
+    {
+        s_currentPool = this;
+        s_currentIndex = index;
+        auto& self = m_workers[index];
+        std::coroutine_handle<> coroutine;
+        while (!m_stop.load(std::memory_order_acquire))
+        {
+            if (findWork(index, coroutine))
+            {
+                coroutine.resume();
+                continue;
+            }
+
+            // Announce that we are going to sleep and look once more,
+            // otherwise a handle enqueued in between would be lost.
+            const auto epoch = self.parked.prepare();
+            if (m_stop.load(std::memory_order_acquire) ||
+                findWork(index, coroutine))
+            {
+                self.parked.cancel();
+                if (coroutine)
+                {
+                    coroutine.resume();
+                }
+                continue;
+            }
+            self.parked.wait(epoch);
+        }
+    }
+
+    bool findWork(std::size_t index, std::coroutine_handle<>& coroutine)
+    {
+        coroutine = nullptr;
+        if (m_workers[index].queue.tryPop(coroutine) ||
+            m_injection.tryPop(coroutine))
+        {
+            return true;
+        }
+        for (std::size_t i = 1; i < m_workers.size(); ++i)
+        {
+            auto& victim = m_workers[(index + i) % m_workers.size()];
+            if (victim.queue.tryPop(coroutine))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void wakeOne() noexcept
+    {
+        const auto count = m_workers.size();
+        const auto start = m_nextWake.fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (m_workers[(start + i) % count].parked.notify())
+            {
+                return;
+            }
+        }
+    }
+
+    static inline thread_local CTP* s_currentPool = nullptr;
+    static inline thread_local std::size_t s_currentIndex = 0;
+
+    std::vector<Worker> m_workers;
+    Queue<std::coroutine_handle<>, 4096> m_injection;
+    std::atomic<std::size_t> m_nextWake = 0;
+    std::atomic<bool> m_stop = false;
 };
 
+#if defined(_WIN32)
+
 struct event_awaiter
 {
     HANDLE event;
+    HANDLE wait = nullptr;
+    std::coroutine_handle<> coroutine;
+    // Resume only after both the registration returned and the event
+    // fired, whichever comes last.
+    std::atomic<int> pending = 2;
+
     bool await_ready() const noexcept
     {
         DBG;
@@ -210,31 +529,200 @@ struct event_awaiter
         return WaitForSingleObject(event, 0) == WAIT_OBJECT_0;
     }
 
-    void await_suspend(std::coroutine_handle<> coroutine) const noexcept
+    void await_suspend(std::coroutine_handle<> coroutine) noexcept
     {
-        // The coroutine handle passed here can be copied elsewhere and resumed
-        // when the event is signaled. Here, we spawn a dedicated thread for
-        // demonstration purposes, but you should have a dedicated low-priority
-        // thread to queue waiting events to.
+        // Instead of blocking a thread per event, hand the event to the
+        // system wait threads which multiplex many handles each. The
+        // callback only enqueues the coroutine, so it is resumed on a
+        // CTP thread.
         DBG;
-        //std::thread thread{[coroutine, this]() noexcept {
-           // WaitForSingleObject(event, INFINITE);
-
-            // The CTP will call coroutine.resume() on an available thread
-            // now
-            ThreadRunner::instance().enqueue(
-                [coroutine, event= event]() { WaitForSingleObject(event, INFINITE);
-            coroutine.resume(); });
-        //}};
-        //thread.detach();
+        this->coroutine = coroutine;
+        RegisterWaitForSingleObject(&wait, event, &event_awaiter::onSignaled,
+            this, INFINITE, WT_EXECUTEONLYONCE);
+        release();
     }
 
     void await_resume() noexcept
     {
         DBG;
+        if (wait)
+        {
+            UnregisterWait(wait);
+        }
         // This is called after the coroutine is resumed in the async thread
-        printf("Event signaled, resuming on thread %i\n",
-            std::this_thread::get_id());
+        std::cout << "Event signaled, resuming on thread "
+                  << std::this_thread::get_id() << std::endl;
+    }
+
+    event_awaiter await_transform(HANDLE event)
+    {
+        DBG;
+        return {event};
+    };
+
+private:
+    static void CALLBACK onSignaled(PVOID context, BOOLEAN) noexcept
+    {
+        static_cast<event_awaiter*>(context)->release();
+    }
+
+    void release() noexcept
+    {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            CTP::instance().enqueue(coroutine);
+        }
+    }
+};
+
+HANDLE createTimer()
+{
+    HANDLE hTimer = CreateWaitableTimer(NULL, TRUE, NULL);
+    LARGE_INTEGER liDueTime;
+
+    liDueTime.QuadPart = -100000000LL;
+    // Set a timer to wait for 10 seconds.
+    SetWaitableTimer(hTimer, &liDueTime, 0, NULL, NULL, 0);
+    return hTimer;
+}
+
+HANDLE createEvent()
+{
+    return CreateEvent(NULL, TRUE, FALSE, NULL);
+}
+
+void closeEvent(HANDLE event)
+{
+    CloseHandle(event);
+}
+
+void setEvent(HANDLE event)
+{
+    SetEvent(event);
+}
+
+#else
+
+/**
+ * Single thread which waits for many file descriptors at once
+ * (eventfd, timerfd, sockets, ...) with epoll. Every registration is
+ * one-shot; once a descriptor becomes readable the waiting coroutine is
+ * handed to the CTP, so the loop thread never runs user code.
+ */
+class EventLoop
+{
+public:
+    static EventLoop& instance()
+    {
+        static EventLoop loop;
+        return loop;
+    }
+
+    // The loop hands coroutines to the CTP, construct the pool first so
+    // it outlives the loop thread.
+    EventLoop()
+        : m_pool(CTP::instance())
+        , m_epoll(epoll_create1(EPOLL_CLOEXEC))
+        , m_wakeup(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &ev);
+        m_thread = std::thread([this] { run(); });
+    }
+
+    ~EventLoop()
+    {
+        m_stop.store(true, std::memory_order_release);
+        const std::uint64_t one = 1;
+        ::write(m_wakeup, &one, sizeof(one));
+        m_thread.join();
+        ::close(m_wakeup);
+        ::close(m_epoll);
+    }
+
+    EventLoop(const EventLoop&) = delete;
+
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * Resumes coroutine on the CTP once fd becomes readable. The
+     * coroutine may be resumed before this function returns.
+     */
+    void watch(int fd, std::coroutine_handle<> coroutine)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = coroutine.address();
+        // A descriptor stays in the interest list after a one-shot
+        // event until unwatch() is called, re-arm it in that case.
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0 && errno == EEXIST)
+        {
+            epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev);
+        }
+    }
+
+    void unwatch(int fd) noexcept
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+private:
+    void run()
+    {
+        epoll_event events[64];
+        while (!m_stop.load(std::memory_order_acquire))
+        {
+            const int count = epoll_wait(m_epoll, events, 64, -1);
+            for (int i = 0; i < count; ++i)
+            {
+                if (events[i].data.ptr != nullptr)
+                {
+                    m_pool.enqueue(
+                        std::coroutine_handle<>::from_address(
+                            events[i].data.ptr));
+                }
+            }
+        }
+    }
+
+    CTP& m_pool;
+    int m_epoll;
+    int m_wakeup;
+    std::atomic<bool> m_stop = false;
+    std::thread m_thread;
+};
+
+// Events are eventfd or timerfd descriptors. Like a manual-reset
+// Win32 event they stay signaled (readable) until somebody reads them.
+using HANDLE = int;
+
+struct event_awaiter
+{
+    HANDLE event;
+
+    bool await_ready() const noexcept
+    {
+        DBG;
+        pollfd fd{event, POLLIN, 0};
+        return ::poll(&fd, 1, 0) == 1;
+    }
+
+    void await_suspend(std::coroutine_handle<> coroutine) const
+    {
+        DBG;
+        // Must not touch this after watch(), the coroutine might
+        // already run on a CTP thread.
+        EventLoop::instance().watch(event, coroutine);
+    }
+
+    void await_resume() noexcept
+    {
+        DBG;
+        EventLoop::instance().unwatch(event);
+        std::cout << "Event signaled, resuming on thread "
+                  << std::this_thread::get_id() << std::endl;
     }
 
     event_awaiter await_transform(HANDLE event)
@@ -244,6 +732,35 @@ struct event_awaiter
     };
 };
 
+HANDLE createEvent()
+{
+    return eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+void setEvent(HANDLE event)
+{
+    const std::uint64_t one = 1;
+    ::write(event, &one, sizeof(one));
+}
+
+// Nobody may wait for the event any more.
+void closeEvent(HANDLE event)
+{
+    ::close(event);
+}
+
+HANDLE createTimer()
+{
+    HANDLE timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    // Set a timer to wait for 10 seconds.
+    itimerspec dueTime{};
+    dueTime.it_value.tv_sec = 10;
+    timerfd_settime(timer, 0, &dueTime, nullptr);
+    return timer;
+}
+
+#endif
+
 inline auto suspend() noexcept
 {
     struct awaiter
@@ -266,24 +783,13 @@ inline auto suspend() noexcept
 
         void await_resume() const noexcept
         {
-            printf("Suspended task now running on thread $i\n",
-                std::this_thread::get_id());
+            std::cout << "Suspended task now running on thread "
+                      << std::this_thread::get_id() << std::endl;
         }
     };
     return awaiter{};
 }
 
-HANDLE createTimer()
-{
-    HANDLE hTimer = CreateWaitableTimer(NULL, TRUE, NULL);
-    LARGE_INTEGER liDueTime;
-
-    liDueTime.QuadPart = -100000000LL;
-    // Set a timer to wait for 10 seconds.
-    SetWaitableTimer(hTimer, &liDueTime, 0, NULL, NULL, 0);
-    return hTimer;
-}
-
 template <typename T>
 struct task
 {
@@ -400,15 +906,37 @@ task<int> test()
 {
     HANDLE event = createTimer();
     co_await event_awaiter{event};
+    closeEvent(event);
+    co_return 0;
+}
+
+task<int> waitFor(HANDLE event, int id)
+{
+    co_await event_awaiter{event};
+    std::cout << "Event " << id << " done" << std::endl;
+    co_return id;
 }
 
 int main()
 {
-    std::cout << "Start thread" << std::endl;
-    ThreadRunner::instance();
+    std::cout << "Start thread pool" << std::endl;
+    CTP::instance();
     std::cout << "Start timer" << std::endl;
-    auto f = test();
+    test();
     std::cout << "Go on" << std::endl;
+
+    // Many pending events share the wait thread(s) instead of blocking
+    // one thread each.
+    std::vector<HANDLE> events;
+    for (int i = 0; i < 8; ++i)
+    {
+        events.push_back(createEvent());
+        waitFor(events.back(), i);
+    }
+    for (auto event : events)
+    {
+        setEvent(event);
+    }
     // Retrieve an event that has yet to be signaled
     // HANDLE event = createTimer();
 
@@ -428,5 +956,9 @@ int main()
     // else
     //     printf("Timer was signaled.\n");
     std::this_thread::sleep_for(std::chrono::seconds(20));
+    for (auto event : events)
+    {
+        closeEvent(event);
+    }
     return 0;
 }
@@ -113,11 +113,15 @@ struct Generator
     Generator& operator=(Generator&& other) noexcept
     {
         DBG;
-        if (handle)
+        if (this != &other)
         {
-            handle.destory();
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
         }
-        handle = std::exchange(other.handle, nullptr);
+        return *this;
     }
 
     ~Generator()
@@ -207,8 +211,11 @@ struct ImprovedGenerator
             {
                 std::rethrow_exception(std::get<std::exception_ptr>(result));
             }
-            return std::get<T>(result) ? std::get<T>(result) :
-                                         *std::get<T*>(result);
+            if (auto* pointer = std::get_if<T*>(&result))
+            {
+                return **pointer;
+            }
+            return std::get<T>(result);
         }
 
         bool hasException() const noexcept
@@ -230,11 +237,15 @@ struct ImprovedGenerator
     ImprovedGenerator& operator=(ImprovedGenerator&& other) noexcept
     {
         DBG;
-        if (handle)
+        if (this != &other)
         {
-            handle.destory();
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
         }
-        handle = std::exchange(other.handle, nullptr);
+        return *this;
     }
 
     ~ImprovedGenerator()
@@ -330,8 +341,11 @@ struct IterableGenerator
         T& getValue() noexcept
         {
             DBG;
-            return std::get<T>(result) ? std::get<T>(result) :
-                                         *std::get<T*>(result);
+            if (auto* pointer = std::get_if<T*>(&result))
+            {
+                return **pointer;
+            }
+            return std::get<T>(result);
         }
 
         bool hasException() const noexcept
@@ -400,11 +414,15 @@ struct IterableGenerator
     IterableGenerator& operator=(IterableGenerator&& other) noexcept
     {
         DBG;
-        if (handle)
+        if (this != &other)
         {
-            handle.destory();
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
         }
-        handle = std::exchange(other.handle, nullptr);
+        return *this;
     }
 
     ~IterableGenerator()
@@ -4,115 +4,73 @@
 #define __PRETTY_FUNCTION__ __FUNCSIG__
 #endif
 
-#include <iostream>
-#include <coroutine>
-#include <optional>
-#include <source_location>
-#include <thread>
+#include "../utility/optional.hpp"
+#include <chrono>
+#include <cstddef>
+#include <vector>
 
-#if !defined(__PRETTY_FUNCTION__) && !defined(__GNUC__)
-#define __PRETTY_FUNCTION__ __FUNCSIG__
-#endif
-
-auto dbg = [](const char* file, const char* func, std::uint32_t line) {
-    std::cerr << "tid: " << std::this_thread::get_id() << " " << file << ":"
-              << func << ":" << line << " called.\n";
-};
-
-#define DBG                                                                    \
-    dbg(std::source_location::current().file_name(),                           \
-        std::source_location::current().function_name(),                       \
-        std::source_location::current().line())
-
-// OptionalHolder is returned as proxy class from
-// promise->get_return_object.  This struct can be implicitly casted
-// to std::optional
-template <typename T, typename P>
-struct OptionalHolder
+std::optional<int> test(std::optional<int> a, std::optional<int> b)
 {
-    std::optional<T> optional;
-    OptionalHolder(P* p)
-    {
-        p->optional = &optional;
-    }
-    OptionalHolder(OptionalHolder&&) = delete;
-
-    OptionalHolder(OptionalHolder const&) = delete;
-
-    operator std::optional<T>() const noexcept
-    {
-        std::cout << "doing implicit conversion of result.\n";
-        return std::move(optional);
-    }
-};
+    co_return(co_await a) * (co_await b);
+}
 
-template <typename T>
-struct OptionalPromise
+// Same as test, written by hand.
+std::optional<int> test_handwritten(
+    std::optional<int> a, std::optional<int> b)
 {
-    std::optional<T>* optional = nullptr;
-
-    OptionalHolder<T, OptionalPromise<T>> get_return_object() noexcept
-    {
-        return {this};
-    }
-
-    std::suspend_never initial_suspend() noexcept
+    if (!a)
     {
-        return {};
+        return std::nullopt;
     }
-
-    std::suspend_never final_suspend() noexcept
+    if (!b)
     {
-        return {};
+        return std::nullopt;
     }
+    return *a * *b;
+}
 
-    void return_value(const T& val) noexcept
+template <typename F>
+void measure(const char* name, const std::vector<std::optional<int>>& values, F f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    long long sum = 0;
+    std::size_t empty = 0;
+    for (std::size_t i = 0; i + 1 < values.size(); ++i)
     {
-        *optional = val;
+        if (const auto n = f(values[i], values[i + 1]))
+        {
+            sum += *n;
+        }
+        else
+        {
+            ++empty;
+        }
     }
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << name << ": "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms (sum " << sum << ", " << empty << " empty)\n";
+}
 
-    void unhandled_exception()
+void benchmark(std::size_t n)
+{
+    // Every 8th value is empty.
+    std::vector<std::optional<int>> values(n);
+    for (std::size_t i = 0; i < n; ++i)
     {
+        if (i % 8 != 0)
+        {
+            values[i] = static_cast<int>(i % 100);
+        }
     }
 
-    template <typename U>
-    auto await_transform(std::optional<U>& value)
+    measure("handwritten", values, test_handwritten);
+    measure("coroutine", values, test);
     {
-        struct awaiter
-        {
-            const std::optional<U>* value;
-
-            bool await_ready() noexcept
-            {
-                return value->has_value();
-            }
-
-            void await_suspend(std::coroutine_handle<> handle) noexcept
-            {
-                handle.destroy();
-            }
-
-            U await_resume() noexcept
-            {
-                return **value;
-            };
-        };
-        return awaiter{&value};
+        // The frames are nested, one buffer serves all calls below.
+        FrameBuffer<1024> buffer;
+        measure("coroutine with FrameBuffer", values, test);
     }
-};
-
-namespace std
-{
-template <typename T, typename... ARGS>
-struct coroutine_traits<std::optional<T>, ARGS...>
-{
-    using promise_type = OptionalPromise<T>;
-};
-} // namespace std
-
-std::optional<int> test(std::optional<int> a, std::optional<int> b)
-{
-    co_return(co_await a) * (co_await b);
 }
 
 int main()
@@ -131,5 +89,6 @@ int main()
     else
         std::cout << "has_value == false.\n";
 
+    benchmark(10'000'000);
     return 0;
 }
@@ -11,7 +11,9 @@
 #include "../utility/future.hpp"
 #include "../utility/trace.hpp"
 
-std::future<int> compute_value()
+// The result lives in the coroutine frame, there is no additional
+// std::promise shared state.
+lazy_future<int> compute_value()
 {
     DBG;
     int result = co_await std::async([] {
@@ -22,7 +24,7 @@ std::future<int> compute_value()
     co_return result;
 }
 
-std::future<void> test()
+lazy_future<void> test()
 {
     co_return co_await std::async([]{
         std::cout << "Yeah" << std::endl;
@@ -31,14 +33,36 @@ std::future<void> test()
     });
 }
 
+// Runs once, no matter how many consumers wait for it.
+shared_task<int> load_config()
+{
+    co_return co_await std::async([] { return 42; });
+}
+
+lazy_future<int> twice(shared_task<int> config)
+{
+    co_return 2 * co_await config;
+}
+
 int main()
 {
     DBG;
     auto bla = compute_value();
     DBG;
+    // lazy_future only starts on the first get/wait/co_await.
+    while (bla.wait_for(std::chrono::seconds(2)) ==
+           std::future_status::timeout)
+    {
+        std::cout << "Still computing" << std::endl;
+    }
     auto result = bla.get();
     test().get();
     std::cout << "Result: " << result << std::endl;
+
+    auto config = load_config();
+    auto doubled = twice(config);
+    std::cout << "Shared: " << doubled.get() << " " << config.get()
+              << std::endl;
     DBG;
 
 }
@@ -0,0 +1,48 @@
+// Batched generator: the coroutine is resumed once per batch instead of
+// once per element.
+
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include "../utility/generator.hpp"
+
+BatchedGenerator<std::uint64_t, 256> iota(std::uint64_t count)
+{
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        co_yield i;
+    }
+}
+
+int main()
+{
+    constexpr std::uint64_t count = 10'000'000;
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t sum = 0;
+    for (auto i : iota(count))
+    {
+        sum += i;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Element wise: " << sum << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                     .count()
+              << "ms" << std::endl;
+
+    // Whole batches can be handed to algorithms which the compiler is
+    // able to vectorize.
+    start = std::chrono::steady_clock::now();
+    sum = 0;
+    auto gen = iota(count);
+    for (auto batch = gen.nextBatch(); !batch.empty(); batch = gen.nextBatch())
+    {
+        sum = std::accumulate(batch.begin(), batch.end(), sum);
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Batch wise: " << sum << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                     .count()
+              << "ms" << std::endl;
+}
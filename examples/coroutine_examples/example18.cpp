@@ -0,0 +1,98 @@
+// Recursive generator: flatten a tree by co_yield'ing the generators
+// of the children. The consumer always resumes the innermost generator
+// directly, so the cost per element does not grow with the depth.
+
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../utility/generator.hpp"
+
+struct Node
+{
+    int value;
+    std::vector<Node> children;
+};
+
+RecursiveGenerator<const int> preorder(const Node& node)
+{
+    co_yield node.value;
+    for (const auto& child : node.children)
+    {
+        co_yield preorder(child);
+    }
+}
+
+RecursiveGenerator<int> range(int begin, int end)
+{
+    for (int i = begin; i < end; ++i)
+    {
+        co_yield i;
+    }
+}
+
+RecursiveGenerator<int> nested(int depth)
+{
+    // Every level adds one generator between the consumer and the
+    // producer of the elements.
+    if (depth == 0)
+    {
+        co_yield range(0, 3);
+        co_return;
+    }
+    co_yield -depth;
+    co_yield nested(depth - 1);
+    co_yield depth;
+}
+
+// Fails before it yields anything.
+RecursiveGenerator<int> failing()
+{
+    throw std::runtime_error("failing");
+    co_return;
+}
+
+RecursiveGenerator<int> withFailingChild()
+{
+    co_yield 1;
+    co_yield failing();
+    co_yield 2;
+}
+
+int main()
+{
+    const Node tree{1, {{2, {{3, {}}, {4, {}}}}, {5, {{6, {{7, {}}}}}}}};
+
+    for (auto i : preorder(tree))
+    {
+        std::cout << i << " ";
+    }
+    std::cout << std::endl;
+
+    for (auto i : nested(3))
+    {
+        std::cout << i << " ";
+    }
+    std::cout << std::endl;
+
+    // The exception of the child reaches the consumer, 2 is never
+    // produced.
+    try
+    {
+        for (auto i : withFailingChild())
+        {
+            std::cout << i << " ";
+            if (i == 2)
+            {
+                std::cout << "error: produced 2" << std::endl;
+                return 1;
+            }
+        }
+        std::cout << "error: no exception" << std::endl;
+        return 1;
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cout << "caught " << e.what() << std::endl;
+    }
+}
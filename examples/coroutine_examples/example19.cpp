@@ -0,0 +1,57 @@
+// Generator frames are recycled by a per-thread cache, rebuilding a
+// generator in a loop does not hit the global allocator.
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include "../utility/generator.hpp"
+
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (auto* p = std::malloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+IterableGenerator<int> count(int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        co_yield i;
+    }
+}
+
+int main()
+{
+    auto gen = count(0);
+    int sum = 0;
+    const auto before = allocations;
+    for (int round = 0; round < 1000; ++round)
+    {
+        // Move assignment releases the old frame into the cache, the
+        // coroutine of the next round picks it up from there.
+        gen = count(3);
+        for (auto i : gen)
+        {
+            sum += i;
+        }
+    }
+    std::cout << "sum " << sum << ", global allocations for 1000 generators: "
+              << allocations - before << std::endl;
+}
@@ -0,0 +1,95 @@
+// Async generator: stream a file chunk by chunk. Every chunk is read on
+// a worker thread (co_await inside the generator), the consumer is an
+// iter1::Task which processes one chunk at a time, so only one chunk is
+// held in memory.
+
+#include <algorithm>
+#include <iostream>
+#include <coroutine>
+#include <thread>
+#include <condition_variable>
+#include <type_traits>
+#include <variant>
+#include <utility>
+#include <filesystem>
+#include <fstream>
+#include "../utility/task1.hpp"
+#include "../utility/async_generator.hpp"
+#include "../utility/task_helper.hpp"
+
+// Reads up to size bytes from stream on a worker thread.
+struct AsyncReadChunk
+{
+    std::ifstream& stream;
+    std::size_t size;
+    std::string result;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    {
+        std::thread{[this, coro] {
+            result.resize(size);
+            stream.read(result.data(), static_cast<std::streamsize>(size));
+            result.resize(static_cast<std::size_t>(stream.gcount()));
+            coro();
+        }}.detach();
+    }
+
+    std::string await_resume() noexcept
+    {
+        return std::move(result);
+    }
+};
+
+AsyncGenerator<std::string> readChunks(
+    std::filesystem::path path, std::size_t chunkSize)
+{
+    std::ifstream stream{path, std::ios::binary};
+    for (;;)
+    {
+        // Named: GCC 12 mishandles the temporary aggregate awaiter and
+        // the worker thread writes into freed memory.
+        AsyncReadChunk read{stream, chunkSize, {}};
+        auto chunk = co_await read;
+        if (chunk.empty())
+        {
+            co_return;
+        }
+        co_yield chunk;
+    }
+}
+
+iter1::Task<std::size_t> countLines(std::filesystem::path path)
+{
+    auto chunks = readChunks(std::move(path), 256);
+    std::size_t lines = 0;
+    while (auto* chunk = co_await chunks.next())
+    {
+        lines += static_cast<std::size_t>(
+            std::count(chunk->begin(), chunk->end(), '\n'));
+    }
+    co_return lines;
+}
+
+// Same with the iterator helpers.
+iter1::Task<std::size_t> countBytes(std::filesystem::path path)
+{
+    auto chunks = readChunks(std::move(path), 256);
+    std::size_t bytes = 0;
+    for (auto it = co_await chunks.begin(); it != chunks.end(); co_await ++it)
+    {
+        bytes += it->size();
+    }
+    co_return bytes;
+}
+
+int main()
+{
+    std::cout << "Lines: " << syncWait(countLines(__FILE__)) << std::endl;
+    std::cout << "Bytes: " << syncWait(countBytes(__FILE__)) << " of "
+              << std::filesystem::file_size(__FILE__) << std::endl;
+}
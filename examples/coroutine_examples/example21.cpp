@@ -0,0 +1,68 @@
+// Generator pipeline: parse -> transform -> aggregate, every stage runs
+// on its own thread(s) and the stages are connected by SPSC ring
+// buffers.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "../utility/generator.hpp"
+#include "../utility/pipeline.hpp"
+
+BatchedGenerator<std::string> lines(int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        co_yield std::to_string(i);
+    }
+}
+
+int parse(const std::string& line)
+{
+    return std::stoi(line);
+}
+
+// Stand-in for an expensive per element computation.
+double transform(int value)
+{
+    double x = value;
+    for (int i = 0; i < 200; ++i)
+    {
+        x = std::sqrt(x + i);
+    }
+    return x;
+}
+
+template <typename F>
+void measure(const char* name, F&& f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = f();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << result << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                     .count()
+              << "ms" << std::endl;
+}
+
+int main()
+{
+    constexpr int count = 1'000'000;
+
+    measure("sequential", [] {
+        double sum = 0;
+        for (const auto& line : lines(count))
+        {
+            sum += transform(parse(line));
+        }
+        return sum;
+    });
+
+    measure("pipeline", [] {
+        double sum = 0;
+        pipeline(lines(count)) | stage(parse) | stage(transform, 4) |
+            sink([&sum](double value) { sum += value; });
+        return sum;
+    });
+}
@@ -1,124 +1,176 @@
-// Generator which implements the ranges concept.
+// Generator which implements the ranges concept. The interface follows
+// std::generator from C++23:
+//
+// generator<Ref, V = void>
+//   value     = V if given, otherwise remove_cvref_t<Ref>
+//   reference = V if given: Ref, otherwise Ref&&
+//   yielded   = reference if it is a reference, otherwise const reference&
+//
+// co_yield takes the argument by reference (yielded), the consumer
+// reads it through a pointer into the coroutine frame. Neither lvalues
+// nor rvalues are copied; a temporary lives until the coroutine is
+// resumed. Only when yielded is an rvalue reference an lvalue has to be
+// copied (as std::generator does).
 
 #include <coroutine>
 #include <algorithm>
+#include <concepts>
+#include <exception>
 #include <iostream>
 #include <iterator>
 #include <ranges>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-template <typename T>
-struct generator
+// co_await reserve_hint{n} inside a generator announces roughly how many
+// elements will follow, so consumers like to_vector can preallocate.
+struct reserve_hint
 {
+    std::size_t size;
+};
+
+template <typename Ref, typename V = void>
+class generator : public std::ranges::view_interface<generator<Ref, V>>
+{
+    using value = std::conditional_t<std::is_void_v<V>,
+        std::remove_cvref_t<Ref>, V>;
+    using reference = std::conditional_t<std::is_void_v<V>, Ref&&, Ref>;
+    using yielded = std::conditional_t<std::is_reference_v<reference>,
+        reference, const reference&>;
+
+public:
     struct promise_type
     {
-        const T* currentValue;
+        std::add_pointer_t<yielded> currentValue = nullptr;
+        std::size_t hint = 0;
 
-        generator<T> get_return_object()
+        generator get_return_object() noexcept
         {
-            return generator<T>{
+            return generator{
                 std::coroutine_handle<promise_type>::from_promise(*this)};
         }
 
-        std::suspend_always initial_suspend()
+        std::suspend_always initial_suspend() const noexcept
         {
             return {};
         }
 
-        std::suspend_always final_suspend() noexcept
+        std::suspend_always final_suspend() const noexcept
         {
             return {};
         }
 
-        std::suspend_always yield_value(const T& value)
+        std::suspend_always yield_value(yielded value) noexcept
         {
             currentValue = std::addressof(value);
             return {};
         }
 
-        void unhandled_exception()
+        // An lvalue can not bind to an rvalue reference; copy it into
+        // the awaiter which lives in the frame while suspended.
+        auto yield_value(const std::remove_reference_t<yielded>& value) requires
+            std::is_rvalue_reference_v<yielded> &&
+            std::constructible_from<std::remove_cvref_t<yielded>,
+                const std::remove_reference_t<yielded>&>
         {
-        }
-    };
+            struct awaiter
+            {
+                std::remove_cvref_t<yielded> copy;
 
-    struct iterator
-    {
-        using iterator_category = std::input_iterator_tag;
-        using difference_type = ptrdiff_t;
-        using value_type = T;
-        using reference = const T&;
-        using pointer = const T*;
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
 
-        std::coroutine_handle<promise_type> coro = nullptr;
+                void await_suspend(
+                    std::coroutine_handle<promise_type> h) noexcept
+                {
+                    h.promise().currentValue = std::addressof(copy);
+                }
 
-        iterator() = default;
-        iterator(std::nullptr_t)
-            : coro(nullptr)
-        {
+                void await_resume() const noexcept
+                {
+                }
+            };
+            return awaiter{value};
         }
 
-        iterator(std::coroutine_handle<promise_type> coroArg)
-            : coro(coroArg)
+        std::suspend_never await_transform(::reserve_hint h) noexcept
         {
+            hint = h.size;
+            return {};
         }
 
-        iterator& operator++()
+        // A generator never waits for anything else.
+        template <typename U>
+        U&& await_transform(U&&) = delete;
+
+        void return_void() const noexcept
         {
-            coro.resume();
-            if (coro.done())
-                coro = nullptr;
-            return *this;
         }
 
-        void operator++(int)
+        // Propagate the exception to the consumer which resumed us.
+        void unhandled_exception()
         {
-            // This postincrement operator meets the requirements of the Ranges
-            // TS InputIterator concept, but not those of Standard C++
-            // InputIterator.
-            ++*this;
+            throw;
         }
+    };
 
-        bool operator==(const iterator& right) const
+    // Move-only input iterator, begin() may only be called once.
+    class iterator
+    {
+    public:
+        using value_type = value;
+        // Not meaningful for a single pass range, but required by
+        // std::weakly_incrementable.
+        using difference_type = std::ptrdiff_t;
+
+        iterator(iterator&& other) noexcept
+            : coro{std::exchange(other.coro, nullptr)}
         {
-            return coro == right.coro;
         }
 
-        bool operator!=(const iterator& right) const
+        iterator& operator=(iterator&& other) noexcept
         {
-            return !(*this == right);
+            coro = std::exchange(other.coro, nullptr);
+            return *this;
         }
 
         reference operator*() const
+            noexcept(std::is_nothrow_copy_constructible_v<reference>)
         {
-            return *coro.promise().currentValue;
+            return static_cast<reference>(*coro.promise().currentValue);
         }
 
-        pointer operator->() const
+        iterator& operator++()
         {
-            return coro.promise().currentValue;
+            coro.resume();
+            return *this;
         }
-    };
 
-    iterator begin()
-    {
-        if (coro)
+        void operator++(int)
         {
-            coro.resume();
-            if (coro.done())
-                return {nullptr};
+            ++*this;
         }
 
-        return {coro};
-    }
+        friend bool operator==(
+            const iterator& i, std::default_sentinel_t) noexcept
+        {
+            return i.coro.done();
+        }
 
-    iterator end()
-    {
-        return {nullptr};
-    }
+    private:
+        friend generator;
 
-    explicit generator(std::coroutine_handle<promise_type> handle)
-        : coro(handle)
-    {
-    }
+        explicit iterator(std::coroutine_handle<promise_type> c) noexcept
+            : coro{c}
+        {
+        }
+
+        std::coroutine_handle<promise_type> coro = nullptr;
+    };
 
     generator() = default;
 
@@ -126,18 +178,20 @@ struct generator
 
     generator& operator=(generator const&) = delete;
 
-    generator(generator&& right)
-        : coro(right.coro)
+    generator(generator&& right) noexcept
+        : coro(std::exchange(right.coro, nullptr))
     {
-        right.coro = nullptr;
     }
 
-    generator& operator=(generator&& right)
+    generator& operator=(generator&& right) noexcept
     {
         if (this != std::addressof(right))
         {
-            coro = right.coro;
-            right.coro = nullptr;
+            if (coro)
+            {
+                coro.destroy();
+            }
+            coro = std::exchange(right.coro, nullptr);
         }
         return *this;
     }
@@ -150,22 +204,105 @@ struct generator
         }
     }
 
+    iterator begin()
+    {
+        // Runs the coroutine up to the first co_yield.
+        coro.resume();
+        return iterator{coro};
+    }
+
+    std::default_sentinel_t end() const noexcept
+    {
+        return {};
+    }
+
+    // Number of elements announced with co_await reserve_hint{n}. Only
+    // known once begin() ran the coroutine to its first co_yield.
+    std::size_t reserve_hint() const noexcept
+    {
+        return coro ? coro.promise().hint : 0;
+    }
+
 private:
+    explicit generator(std::coroutine_handle<promise_type> handle) noexcept
+        : coro(handle)
+    {
+    }
+
     std::coroutine_handle<promise_type> coro = nullptr;
 };
 
+// Stand-in for ranges::to<std::vector> which honours reserve_hint.
+template <typename Ref, typename V>
+auto to_vector(generator<Ref, V> gen)
+{
+    std::vector<std::ranges::range_value_t<generator<Ref, V>>> result;
+    auto it = gen.begin();
+    result.reserve(gen.reserve_hint());
+    for (; it != gen.end(); ++it)
+    {
+        result.push_back(*it);
+    }
+    return result;
+}
+
+static_assert(std::ranges::input_range<generator<int>>);
+static_assert(std::ranges::view<generator<int>>);
+static_assert(std::same_as<std::ranges::range_reference_t<generator<int>>,
+    int&&>);
+static_assert(
+    std::same_as<std::ranges::range_reference_t<generator<const int&>>,
+        const int&>);
+static_assert(std::same_as<
+    std::ranges::range_value_t<generator<std::string_view, std::string>>,
+    std::string>);
+
 generator<int> generate(int start, int end)
 {
+    co_await reserve_hint{static_cast<std::size_t>(end - start)};
     for (int i = start; i < end; ++i)
     {
         co_yield i;
     }
 }
 
+// Yields references to the strings owned by the vector, nothing is
+// copied.
+generator<const std::string&> names(const std::vector<std::string>& v)
+{
+    for (const auto& name : v)
+    {
+        co_yield name;
+    }
+    // Temporaries are fine as well, they live until the next resume.
+    co_yield std::string{"temporary"};
+}
+
 int main()
 {
     for (auto i : generate(10, 20))
     {
         std::cout << i << std::endl;
     }
+
+    // Works with range adaptors and algorithms.
+    auto squares = generate(0, 10) |
+                   std::views::filter([](int i) { return i % 2 == 0; }) |
+                   std::views::transform([](int i) { return i * i; });
+    for (auto i : squares)
+    {
+        std::cout << i << " ";
+    }
+    std::cout << std::endl;
+
+    const std::vector<std::string> v{"a", "b", "c"};
+    for (const auto& name : names(v) | std::views::take(2))
+    {
+        std::cout << name << " at " << static_cast<const void*>(&name)
+                  << std::endl;
+    }
+
+    auto values = to_vector(generate(0, 1000));
+    std::cout << values.size() << " values, capacity " << values.capacity()
+              << std::endl;
 }
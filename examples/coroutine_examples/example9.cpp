@@ -1,6 +1,9 @@
+#include <atomic>
 #include <coroutine>
 #include <iostream>
+#include <thread>
 #include <utility>
+#include <vector>
 
 auto dbg = [](const char* s) { std::cout << "Function " << s << " called.\n"; };
 
@@ -11,7 +14,7 @@ using namespace std;
 class task
 {
 public:
-    inline static int counter = 0;
+    inline static std::atomic<int> counter = 0;
 
     class promise_type
     {
@@ -211,6 +214,12 @@ struct sync_wait_task
     }
 };
 
+// Multi-producer, single-consumer executor. Every `schedule_op` lives
+// in the frame of the awaiting coroutine and is used as an intrusive
+// node, so scheduling never allocates. Producers push onto an atomic
+// LIFO stack (Treiber stack); the single consumer detaches the whole
+// stack with one exchange and reverses it, which yields FIFO order
+// within each detached batch.
 struct manual_executor
 {
     struct schedule_op
@@ -235,8 +244,7 @@ struct manual_executor
         {
             DBG;
             continuation_ = continuation;
-            next_ = executor_.head_;
-            executor_.head_ = this;
+            executor_.push(this);
         }
 
         void await_resume() noexcept
@@ -245,7 +253,7 @@ struct manual_executor
         }
     };
 
-    schedule_op* head_ = nullptr;
+    std::atomic<schedule_op*> head_ = nullptr;
 
     schedule_op schedule() noexcept
     {
@@ -253,14 +261,43 @@ struct manual_executor
         return schedule_op{*this};
     }
 
+    // May be called from any thread. After the node is published
+    // the consumer may resume (and destroy) the awaiting coroutine at
+    // any time, so `op` must not be touched after the successful CAS.
+    void push(schedule_op* op) noexcept
+    {
+        auto* old_head = head_.load(std::memory_order_relaxed);
+        do
+        {
+            op->next_ = old_head;
+        } while (!head_.compare_exchange_weak(old_head, op,
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Must only be called from one thread at a time.
     void drain()
     {
         DBG;
-        while (head_ != nullptr)
+        while (auto* batch = head_.exchange(nullptr, std::memory_order_acquire))
         {
-            auto* item = head_;
-            head_ = item->next_;
-            item->continuation_.resume();
+            // Reverse the detached stack to get the push order back.
+            schedule_op* fifo = nullptr;
+            while (batch != nullptr)
+            {
+                auto* next = batch->next_;
+                batch->next_ = fifo;
+                fifo = batch;
+                batch = next;
+            }
+
+            while (fifo != nullptr)
+            {
+                // Read the successor before resuming, the resumed
+                // coroutine may destroy the node.
+                auto* item = fifo;
+                fifo = item->next_;
+                item->continuation_.resume();
+            }
         }
     }
 
@@ -287,6 +324,15 @@ task bar()
     co_await foo();
 }
 
+task hop(manual_executor& executor, int id)
+{
+    // Suspend on the producer thread and continue on the thread which
+    // drains the executor.
+    co_await executor.schedule();
+    std::cout << "Task " << id << " resumed on " << std::this_thread::get_id()
+              << std::endl;
+}
+
 int main()
 {
 
@@ -389,7 +435,32 @@ int main()
     // will eventually reach the end and call the task destructor.
 
     DBG;
-    // manual_executor ex;
     auto b = sync_wait_task::start(bar());
-    // b.resume();
+
+    // Several producer threads schedule onto the same executor while
+    // main drains it.
+    manual_executor ex;
+    struct started_task
+    {
+        task t;
+        sync_wait_task waiter;
+    };
+    std::vector<started_task> started[4];
+    {
+        std::vector<std::jthread> producers;
+        for (int p = 0; p < 4; ++p)
+        {
+            producers.emplace_back([&ex, &started, p] {
+                for (int i = 0; i < 4; ++i)
+                {
+                    // `start` only borrows the task, so it has to outlive
+                    // the suspended coroutine.
+                    auto t = hop(ex, p * 4 + i);
+                    auto waiter = sync_wait_task::start(std::move(t));
+                    started[p].push_back({std::move(t), std::move(waiter)});
+                }
+            });
+        }
+    }
+    ex.drain();
 }
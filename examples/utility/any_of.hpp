@@ -0,0 +1,206 @@
+// Owning, move-only type erasure with a small buffer and a static
+// vtable, a reusable version of the UniquePrintable idiom from
+// cppknowhow.org:
+//
+//   struct Printable
+//   {
+//       void (*print)(const void* self, std::ostream& os);
+//
+//       template <typename T>
+//       static constexpr Printable vtable_for = {
+//           [](const void* self, std::ostream& os) {
+//               os << *static_cast<const T*>(self);
+//           }};
+//   };
+//
+//   basic_any_of<Printable> p = 42;
+//   p.call<&Printable::print>(std::cout);
+//
+// An Interface is a struct of function pointers which take the erased
+// object as first argument, plus a variable template vtable_for<T>
+// which fills them in for T. Objects which fit into SBOSize bytes with
+// an alignment of at most Align (and can be moved without throwing)
+// are stored inline; only larger ones are allocated. Every object
+// holds one pointer to a vtable per type instead of a heap allocated
+// PrintableImpl with its own virtual table pointer.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Interface, std::size_t SBOSize = 32,
+    std::size_t Align = alignof(std::max_align_t)>
+class basic_any_of
+{
+public:
+    basic_any_of() noexcept = default;
+
+    // Stores a decayed copy of value, like UniquePrintable(T t).
+    template <typename T,
+        typename = std::enable_if_t<
+            !std::is_same_v<std::decay_t<T>, basic_any_of>>>
+    basic_any_of(T&& value)
+        : basic_any_of(std::in_place_type<std::decay_t<T>>,
+            std::forward<T>(value))
+    {
+    }
+
+    template <typename T, typename... Args>
+    explicit basic_any_of(std::in_place_type_t<T>, Args&&... args)
+        : m_vtable{&s_vtable<T>}
+    {
+        if constexpr (fitsInline<T>())
+        {
+            ::new (static_cast<void*>(m_storage)) T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            ::new (static_cast<void*>(m_storage))
+                T*(new T(std::forward<Args>(args)...));
+        }
+    }
+
+    basic_any_of(const basic_any_of&) = delete;
+
+    basic_any_of& operator=(const basic_any_of&) = delete;
+
+    basic_any_of(basic_any_of&& other) noexcept
+        : m_vtable{std::exchange(other.m_vtable, nullptr)}
+    {
+        if (m_vtable != nullptr)
+        {
+            m_vtable->relocate(m_storage, other.m_storage);
+        }
+    }
+
+    basic_any_of& operator=(basic_any_of&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_vtable = std::exchange(other.m_vtable, nullptr);
+            if (m_vtable != nullptr)
+            {
+                m_vtable->relocate(m_storage, other.m_storage);
+            }
+        }
+        return *this;
+    }
+
+    ~basic_any_of()
+    {
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if (m_vtable != nullptr)
+        {
+            m_vtable->destroy(m_storage);
+            m_vtable = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_vtable != nullptr;
+    }
+
+    // True if the object lives in the small buffer.
+    bool isInline() const noexcept
+    {
+        return m_vtable != nullptr && !m_vtable->onHeap;
+    }
+
+    // True if objects of type T are stored in the small buffer.
+    template <typename T>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(T) <= SBOSize && alignof(T) <= Align &&
+               std::is_nothrow_move_constructible_v<T>;
+    }
+
+    const Interface& interface() const noexcept
+    {
+        return m_vtable->interface;
+    }
+
+    void* data() noexcept
+    {
+        return m_vtable->onHeap ? *reinterpret_cast<void**>(m_storage) :
+                                  static_cast<void*>(m_storage);
+    }
+
+    const void* data() const noexcept
+    {
+        return m_vtable->onHeap ? *reinterpret_cast<void* const*>(m_storage) :
+                                  static_cast<const void*>(m_storage);
+    }
+
+    // Calls the interface function Member with the erased object and
+    // args. Must not be called on an empty object.
+    template <auto Member, typename... Args>
+    decltype(auto) call(Args&&... args) const
+    {
+        return (m_vtable->interface.*Member)(data(), std::forward<Args>(args)...);
+    }
+
+    template <auto Member, typename... Args>
+    decltype(auto) call(Args&&... args)
+    {
+        return (m_vtable->interface.*Member)(data(), std::forward<Args>(args)...);
+    }
+
+private:
+    struct VTable
+    {
+        Interface interface;
+        // Moves the object from src to dst and ends the lifetime of
+        // the object in src.
+        void (*relocate)(std::byte* dst, std::byte* src) noexcept;
+        void (*destroy)(std::byte* storage) noexcept;
+        bool onHeap;
+    };
+
+    template <typename T>
+    static void relocate(std::byte* dst, std::byte* src) noexcept
+    {
+        if constexpr (fitsInline<T>())
+        {
+            auto* object = std::launder(reinterpret_cast<T*>(src));
+            ::new (static_cast<void*>(dst)) T(std::move(*object));
+            std::destroy_at(object);
+        }
+        else
+        {
+            ::new (static_cast<void*>(dst)) T*(*reinterpret_cast<T**>(src));
+        }
+    }
+
+    template <typename T>
+    static void destroy(std::byte* storage) noexcept
+    {
+        if constexpr (fitsInline<T>())
+        {
+            std::destroy_at(std::launder(reinterpret_cast<T*>(storage)));
+        }
+        else
+        {
+            delete *reinterpret_cast<T**>(storage);
+        }
+    }
+
+    template <typename T>
+    static constexpr VTable s_vtable = {Interface::template vtable_for<T>,
+        &relocate<T>, &destroy<T>, !fitsInline<T>()};
+
+    static_assert(SBOSize >= sizeof(void*) && Align >= alignof(void*),
+        "The buffer has to hold a pointer");
+
+    const VTable* m_vtable = nullptr;
+    alignas(Align) std::byte m_storage[SBOSize];
+};
@@ -0,0 +1,283 @@
+// Generator whose body may co_await (e.g. asynchronous I/O) between
+// the co_yields. The consumer has to be a coroutine itself and pulls
+// the elements one by one with
+//
+//   while (auto* value = co_await gen.next()) { ... }
+//
+// or with the iterator helpers, in the style of a "for co_await" loop:
+//
+//   for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+//   { ... }
+//
+// The producer only runs while the consumer waits in next(); after a
+// co_yield it is suspended until the consumer asks for the next
+// element. This gives natural backpressure: at most one element is in
+// flight and memory stays bounded no matter how fast the producer is.
+// Control is handed back and forth with symmetric transfer, so the
+// producer and consumer may end up running on whichever thread resumed
+// the producer's last co_await.
+
+#pragma once
+
+#include "trace.hpp"
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+template <typename T>
+struct AsyncGenerator
+{
+    struct promise_type
+    {
+        AsyncGenerator get_return_object() noexcept
+        {
+            DBG;
+            return AsyncGenerator{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        // Suspends the producer and continues the consumer which is
+        // waiting in next().
+        struct YieldAwaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> producer) noexcept
+            {
+                return producer.promise().consumer;
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        YieldAwaiter final_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        // The value stays alive in the producer's frame until the
+        // consumer asks for the next element.
+        YieldAwaiter yield_value(T& value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        YieldAwaiter yield_value(T&& value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+            DBG;
+            current = nullptr;
+        }
+
+        void unhandled_exception() noexcept
+        {
+            DBG;
+            current = nullptr;
+            exception = std::current_exception();
+        }
+
+        std::coroutine_handle<> consumer;
+        T* current = nullptr;
+        std::exception_ptr exception;
+    };
+
+    AsyncGenerator(AsyncGenerator&& other) noexcept
+        : handle{std::exchange(other.handle, nullptr)}
+    {
+        DBG;
+    }
+
+    AsyncGenerator& operator=(AsyncGenerator&& other) noexcept
+    {
+        DBG;
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    // Must not be destroyed while the producer runs, i.e. while a
+    // consumer waits in next().
+    ~AsyncGenerator()
+    {
+        DBG;
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    // Resumes the producer until it yields the next element. The result
+    // of co_await is a pointer to the element, valid until the next
+    // call, or nullptr once the generator is exhausted. Exceptions of
+    // the producer are rethrown to the consumer.
+    auto next() noexcept
+    {
+        return NextAwaiter{handle};
+    }
+
+    // Input iterator over the elements. Advancing it has to be
+    // co_awaited, it compares equal to end() once the generator is
+    // exhausted.
+    class Iterator
+    {
+    public:
+        using value_type = std::remove_cv_t<T>;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() noexcept = default;
+
+        T& operator*() const noexcept
+        {
+            return *m_current;
+        }
+
+        T* operator->() const noexcept
+        {
+            return m_current;
+        }
+
+        // co_await ++it
+        auto operator++() noexcept
+        {
+            struct awaiter
+            {
+                NextAwaiter next;
+                Iterator& iterator;
+
+                bool await_ready() const noexcept
+                {
+                    return next.await_ready();
+                }
+
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<> consumer) noexcept
+                {
+                    return next.await_suspend(consumer);
+                }
+
+                Iterator& await_resume() const
+                {
+                    iterator.m_current = next.await_resume();
+                    return iterator;
+                }
+            };
+            return awaiter{NextAwaiter{m_producer}, *this};
+        }
+
+        friend bool operator==(
+            const Iterator& it, std::default_sentinel_t) noexcept
+        {
+            return it.m_current == nullptr;
+        }
+
+    private:
+        friend AsyncGenerator;
+
+        Iterator(std::coroutine_handle<promise_type> producer, T* current) noexcept
+            : m_producer{producer}
+            , m_current{current}
+        {
+        }
+
+        std::coroutine_handle<promise_type> m_producer;
+        T* m_current = nullptr;
+    };
+
+    // co_await gen.begin() produces the first element.
+    auto begin() noexcept
+    {
+        struct awaiter
+        {
+            NextAwaiter next;
+
+            bool await_ready() const noexcept
+            {
+                return next.await_ready();
+            }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<> consumer) noexcept
+            {
+                return next.await_suspend(consumer);
+            }
+
+            Iterator await_resume() const
+            {
+                return Iterator{next.producer, next.await_resume()};
+            }
+        };
+        return awaiter{NextAwaiter{handle}};
+    }
+
+    std::default_sentinel_t end() const noexcept
+    {
+        return {};
+    }
+
+private:
+    struct NextAwaiter
+    {
+        std::coroutine_handle<promise_type> producer;
+
+        bool await_ready() const noexcept
+        {
+            return !producer || producer.done();
+        }
+
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<> consumer) noexcept
+        {
+            producer.promise().consumer = consumer;
+            return producer;
+        }
+
+        T* await_resume() const
+        {
+            if (!producer)
+            {
+                return nullptr;
+            }
+            auto& promise = producer.promise();
+            if (promise.exception)
+            {
+                std::rethrow_exception(
+                    std::exchange(promise.exception, nullptr));
+            }
+            return producer.done() ? nullptr : promise.current;
+        }
+    };
+
+    explicit AsyncGenerator(std::coroutine_handle<promise_type> h) noexcept
+        : handle{h}
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
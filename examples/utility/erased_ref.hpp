@@ -0,0 +1,157 @@
+// Non-owning type erasure, a generalization of the PrintableRef idiom
+// from cppknowhow.org: a pointer to the object plus one function
+// pointer per signature, stored inline. There is no vtable to load
+// first and the whole reference is trivially copyable, so it is passed
+// in registers. function_ref<Sig> is the single signature case and is
+// two pointers large.
+//
+// Each of the Signatures is either
+//  - a function type R(Args...), callable as ref(args...), which
+//    invokes the referenced object (a lambda, function, ...), or
+//  - a method: a type with a nested signature R(Args...) and a static
+//    call(Self& self, Args...) which implements it for every Self.
+//    It is called as ref(Method{}, args...) or ref.call<Method>(args...):
+//
+//      struct print
+//      {
+//          using signature = void(std::ostream&);
+//
+//          template <typename Self>
+//          static void call(const Self& self, std::ostream& os)
+//          {
+//              os << self;
+//          }
+//      };
+//
+//      void printit(erased_ref<print> p);
+//
+// The referenced object has to outlive the reference. Like a reference
+// parameter it is meant for arguments of functions which do not keep
+// the callable.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+union erased_ref_storage
+{
+    void* object;
+    void (*function)();
+};
+
+template <typename T>
+T* erased_ref_target(erased_ref_storage storage) noexcept
+{
+    if constexpr (std::is_function_v<T>)
+    {
+        return reinterpret_cast<T*>(storage.function);
+    }
+    else
+    {
+        return static_cast<T*>(storage.object);
+    }
+}
+
+template <typename Derived, typename Signature>
+struct erased_ref_entry;
+
+template <typename Derived, typename Method, typename Signature>
+struct erased_ref_method_entry;
+
+template <typename Derived, typename R, typename... Args>
+struct erased_ref_entry<Derived, R(Args...)>
+{
+    template <typename T>
+    static R thunk(erased_ref_storage storage, Args... args)
+    {
+        return std::invoke(
+            *erased_ref_target<T>(storage), std::forward<Args>(args)...);
+    }
+
+    R operator()(Args... args) const
+    {
+        return m_fn(static_cast<const Derived&>(*this).m_storage,
+            std::forward<Args>(args)...);
+    }
+
+    R (*m_fn)(erased_ref_storage, Args...);
+};
+
+template <typename Derived, typename Method>
+    requires requires { typename Method::signature; }
+struct erased_ref_entry<Derived, Method>
+    : erased_ref_method_entry<Derived, Method, typename Method::signature>
+{
+};
+
+template <typename Derived, typename Method, typename R, typename... Args>
+struct erased_ref_method_entry<Derived, Method, R(Args...)>
+{
+    template <typename T>
+    static R thunk(erased_ref_storage storage, Args... args)
+    {
+        return Method::call(
+            *erased_ref_target<T>(storage), std::forward<Args>(args)...);
+    }
+
+    R operator()(Method, Args... args) const
+    {
+        return m_fn(static_cast<const Derived&>(*this).m_storage,
+            std::forward<Args>(args)...);
+    }
+
+    R (*m_fn)(erased_ref_storage, Args...);
+};
+
+template <typename... Signatures>
+class erased_ref : public erased_ref_entry<erased_ref<Signatures...>, Signatures>...
+{
+public:
+    // Binds to any object (or function) which supports all signatures.
+    // Temporaries are fine as long as the reference does not outlive
+    // the full expression, e.g. f(erased_ref<...>{[] { ... }}).
+    template <typename T>
+        requires(!std::is_same_v<std::remove_cvref_t<T>, erased_ref>)
+    erased_ref(T&& object) noexcept
+        : erased_ref_entry<erased_ref, Signatures>{
+              &erased_ref_entry<erased_ref, Signatures>::template thunk<
+                  std::remove_reference_t<T>>}...
+    {
+        if constexpr (std::is_function_v<std::remove_reference_t<T>>)
+        {
+            m_storage.function = reinterpret_cast<void (*)()>(&object);
+        }
+        else
+        {
+            m_storage.object = const_cast<void*>(
+                static_cast<const void*>(std::addressof(object)));
+        }
+    }
+
+    erased_ref(const erased_ref&) = default;
+
+    erased_ref& operator=(const erased_ref&) = default;
+
+    using erased_ref_entry<erased_ref, Signatures>::operator()...;
+
+    template <typename Method, typename... Args>
+    decltype(auto) call(Args&&... args) const
+    {
+        return (*this)(Method{}, std::forward<Args>(args)...);
+    }
+
+private:
+    template <typename, typename>
+    friend struct erased_ref_entry;
+
+    template <typename, typename, typename>
+    friend struct erased_ref_method_entry;
+
+    erased_ref_storage m_storage;
+};
+
+template <typename Signature>
+using function_ref = erased_ref<Signature>;
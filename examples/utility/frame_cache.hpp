@@ -0,0 +1,215 @@
+// Per-thread cache of coroutine frames. A promise type which derives
+// from RecyclingFrame allocates its coroutine frame through the cache:
+// a destroyed frame is kept in a free list of its size class and the
+// next coroutine of a similar size created on the same thread reuses
+// it instead of going to malloc. Useful for short lived coroutines
+// like generators which are recreated over and over.
+//
+// FrameStack is the alternative for coroutines whose frames are
+// strictly nested: frames of promise types derived from StackedFrame
+// are carved out of a FrameBuffer on the caller's stack instead of the
+// heap.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+
+class FrameCache
+{
+public:
+    // Frames are grouped in size classes of s_granularity bytes, larger
+    // frames are not cached.
+    static constexpr std::size_t s_granularity = 64;
+    static constexpr std::size_t s_classes = 32;
+    static constexpr std::size_t s_maxCachedPerClass = 16;
+
+    static void* allocate(std::size_t size)
+    {
+        const auto index = sizeClass(size);
+        if (index >= s_classes || t_destroyed)
+        {
+            return ::operator new(size);
+        }
+        auto& bucket = local().buckets[index];
+        if (bucket.head != nullptr)
+        {
+            auto* block = bucket.head;
+            bucket.head = block->next;
+            --bucket.count;
+            return block;
+        }
+        return ::operator new((index + 1) * s_granularity);
+    }
+
+    static void deallocate(void* p, std::size_t size) noexcept
+    {
+        const auto index = sizeClass(size);
+        if (index >= s_classes || t_destroyed)
+        {
+            ::operator delete(p);
+            return;
+        }
+        auto& bucket = local().buckets[index];
+        if (bucket.count == s_maxCachedPerClass)
+        {
+            ::operator delete(p);
+            return;
+        }
+        bucket.head = ::new (p) FreeBlock{bucket.head};
+        ++bucket.count;
+    }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct Bucket
+    {
+        FreeBlock* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    struct ThreadCache
+    {
+        Bucket buckets[s_classes];
+
+        ~ThreadCache()
+        {
+            // Frames released after this point (e.g. by static objects
+            // of the main thread) go straight to operator delete.
+            t_destroyed = true;
+            for (auto& bucket : buckets)
+            {
+                while (bucket.head != nullptr)
+                {
+                    ::operator delete(
+                        std::exchange(bucket.head, bucket.head->next));
+                }
+            }
+        }
+    };
+
+    static std::size_t sizeClass(std::size_t size) noexcept
+    {
+        return (size + s_granularity - 1) / s_granularity - 1;
+    }
+
+    static ThreadCache& local() noexcept
+    {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static inline thread_local bool t_destroyed = false;
+};
+
+// Base class for promise types whose frames should be recycled.
+struct RecyclingFrame
+{
+    static void* operator new(std::size_t size)
+    {
+        return FrameCache::allocate(size);
+    }
+
+    static void operator delete(void* p, std::size_t size) noexcept
+    {
+        FrameCache::deallocate(p, size);
+    }
+};
+
+// Stack allocator for coroutine frames which are destroyed in reverse
+// order of their creation, e.g. coroutines which never suspend and so
+// are finished (or destroyed) before they return to their caller. The
+// memory comes from the innermost FrameBuffer of the current thread;
+// without one, or when it is exhausted, frames go to operator new.
+class FrameStack
+{
+public:
+    static void* allocate(std::size_t size)
+    {
+        size = (size + s_alignment - 1) / s_alignment * s_alignment;
+        auto* region = t_current;
+        if (region != nullptr &&
+            static_cast<std::size_t>(region->end - region->top) >= size)
+        {
+            return std::exchange(region->top, region->top + size);
+        }
+        return ::operator new(size);
+    }
+
+    static void deallocate(void* p, std::size_t) noexcept
+    {
+        auto* region = t_current;
+        auto* block = static_cast<std::byte*>(p);
+        if (region != nullptr && !std::less<>{}(block, region->begin) &&
+            std::less<>{}(block, region->end))
+        {
+            // The last frame allocated from the region.
+            region->top = block;
+            return;
+        }
+        ::operator delete(p);
+    }
+
+private:
+    template <std::size_t>
+    friend class FrameBuffer;
+
+    static constexpr std::size_t s_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    struct Region
+    {
+        std::byte* begin;
+        std::byte* top;
+        std::byte* end;
+        Region* previous;
+    };
+
+    static inline thread_local Region* t_current = nullptr;
+};
+
+// Makes Size bytes of (usually stack) memory available to the
+// FrameStack of the current thread for its lifetime. Frames allocated
+// from it must be gone before it is destroyed.
+template <std::size_t Size>
+class FrameBuffer
+{
+public:
+    FrameBuffer() noexcept
+        : m_region{m_storage, m_storage, m_storage + Size, FrameStack::t_current}
+    {
+        FrameStack::t_current = &m_region;
+    }
+
+    FrameBuffer(const FrameBuffer&) = delete;
+
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    ~FrameBuffer()
+    {
+        FrameStack::t_current = m_region.previous;
+    }
+
+private:
+    alignas(FrameStack::s_alignment) std::byte m_storage[Size];
+    FrameStack::Region m_region;
+};
+
+// Base class for promise types whose frames are strictly nested.
+struct StackedFrame
+{
+    static void* operator new(std::size_t size)
+    {
+        return FrameStack::allocate(size);
+    }
+
+    static void operator delete(void* p, std::size_t size) noexcept
+    {
+        FrameStack::deallocate(p, size);
+    }
+};
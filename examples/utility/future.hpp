@@ -1,11 +1,17 @@
+#include <atomic>
 #include <chrono>
 #include <coroutine>
+#include <cstdint>
 #include <exception>
 #include <future>
 #include <iostream>
+#include <semaphore>
 #include <thread>
 #include <type_traits>
+#include <utility>
+#include <variant>
 #include "trace.hpp"
+#include "future_poller.hpp"
 
 
 // Enable the use of std::future<T> as a coroutine type
@@ -91,35 +97,628 @@ struct std::coroutine_traits<std::future<void>, Args...>
     };
 };
 
-// Allow co_await'ing std::future<T> and std::future<void>
-// by naively spawning a new thread for each co_await.
+// Allow co_await'ing std::future<T> and std::future<void>. Instead of
+// spawning a thread per co_await, the awaiter registers itself with
+// the shared FuturePoller which watches all pending futures on one
+// thread.
 template <typename T>
 auto operator co_await(std::future<T> future) noexcept
 {
-    struct awaiter
+    struct awaiter : FuturePoller::Waiter
     {
         std::future<T> future;
+
+        explicit awaiter(std::future<T>&& f) noexcept
+            : FuturePoller::Waiter{&awaiter::isFutureReady}
+            , future{std::move(f)}
+        {
+        }
+
         bool await_ready() const noexcept
         {
             DBG;
             using namespace std::chrono_literals;
             return future.wait_for(0s) != std::future_status::timeout;
         }
-        void await_suspend(std::coroutine_handle<> cont) const
+        void await_suspend(std::coroutine_handle<> cont)
         {
             DBG;
-            std::thread([this, cont] {
-                DBG;
-                future.wait();
-                cont();
-            }).detach();
-            DBG;
+            // The awaiter lives in the suspended coroutine's frame, so
+            // the poller can refer to it until it resumes cont.
+            continuation = cont;
+            FuturePoller::instance().watch(*this);
         }
         T await_resume()
         {
             DBG;
             return future.get();
         }
+
+        static bool isFutureReady(FuturePoller::Waiter& waiter) noexcept
+        {
+            using namespace std::chrono_literals;
+            return static_cast<awaiter&>(waiter).future.wait_for(0s) !=
+                   std::future_status::timeout;
+        }
     };
     return awaiter{std::move(future)};
 }
+
+// Result storage of lazy_future, lives in the promise.
+template <typename T>
+struct LazyFutureResult
+{
+    std::variant<std::monostate, T, std::exception_ptr> value;
+
+    template <typename V>
+    void return_value(V&& v) noexcept(std::is_nothrow_constructible_v<T, V&&>)
+    {
+        DBG;
+        value.template emplace<1>(std::forward<V>(v));
+    }
+
+    T take()
+    {
+        if (std::holds_alternative<std::exception_ptr>(value))
+        {
+            std::rethrow_exception(std::get<2>(value));
+        }
+        return std::move(std::get<1>(value));
+    }
+
+    const T& get() const
+    {
+        if (std::holds_alternative<std::exception_ptr>(value))
+        {
+            std::rethrow_exception(std::get<2>(value));
+        }
+        return std::get<1>(value);
+    }
+
+    void setException(std::exception_ptr e) noexcept
+    {
+        value.template emplace<2>(std::move(e));
+    }
+};
+
+template <>
+struct LazyFutureResult<void>
+{
+    std::exception_ptr exception;
+
+    void return_void() noexcept
+    {
+        DBG;
+    }
+
+    void take()
+    {
+        get();
+    }
+
+    void get() const
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void setException(std::exception_ptr e) noexcept
+    {
+        exception = std::move(e);
+    }
+};
+
+// Coroutine return type which can be used like std::future but does not
+// need a separate shared state: the result is stored in the coroutine
+// frame (which is still allocated like any coroutine frame) and a single
+// atomic word tracks the progress. The coroutine is started lazily by
+// the first get()/wait()/wait_for() or co_await.
+//
+// Like std::future a lazy_future has a single consumer: either one
+// coroutine co_awaits it, or one thread at a time blocks in
+// get()/wait()/wait_for(). There is room for one waiter only, so a
+// second concurrent waiter calls std::terminate() instead of missing
+// its wake up. Use shared_task for several consumers.
+//
+// The state word holds one of
+//   s_notStarted, s_running, s_ready
+//   the address of an awaiting coroutine
+//   the address of a blocked thread's BlockingWaiter, tagged with bit 0
+template <typename T>
+class lazy_future
+{
+    static constexpr std::uintptr_t s_notStarted = 0;
+    static constexpr std::uintptr_t s_running = 2;
+    static constexpr std::uintptr_t s_ready = 4;
+    static constexpr std::uintptr_t s_blockingTag = 1;
+
+    // Lives on the stack of the thread which blocks in wait().
+    struct BlockingWaiter
+    {
+        std::binary_semaphore signal{0};
+    };
+
+public:
+    struct promise_type : LazyFutureResult<T>
+    {
+        std::atomic<std::uintptr_t> state = s_notStarted;
+
+        lazy_future get_return_object() noexcept
+        {
+            DBG;
+            return lazy_future{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        auto final_suspend() const noexcept
+        {
+            struct awaiter
+            {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> self) noexcept
+                {
+                    DBG;
+                    const auto waiter = self.promise().state.exchange(
+                        s_ready, std::memory_order_acq_rel);
+                    if (waiter & s_blockingTag)
+                    {
+                        reinterpret_cast<BlockingWaiter*>(
+                            waiter & ~s_blockingTag)
+                            ->signal.release();
+                    }
+                    else if (waiter != s_running)
+                    {
+                        return std::coroutine_handle<>::from_address(
+                            reinterpret_cast<void*>(waiter));
+                    }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept
+                {
+                }
+            };
+            return awaiter{};
+        }
+
+        void unhandled_exception() noexcept
+        {
+            DBG;
+            this->setException(std::current_exception());
+        }
+    };
+
+    lazy_future(lazy_future&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, nullptr)}
+    {
+    }
+
+    lazy_future& operator=(lazy_future&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~lazy_future()
+    {
+        reset();
+    }
+
+    bool valid() const noexcept
+    {
+        return static_cast<bool>(m_handle);
+    }
+
+    bool is_ready() const noexcept
+    {
+        return state().load(std::memory_order_acquire) == s_ready;
+    }
+
+    // Blocks until the coroutine finished. Starts it on the calling
+    // thread if nobody did so far.
+    void wait() const
+    {
+        start();
+        BlockingWaiter waiter;
+        if (attach(waiter))
+        {
+            waiter.signal.acquire();
+        }
+    }
+
+    template <typename Rep, typename Period>
+    std::future_status wait_for(
+        const std::chrono::duration<Rep, Period>& timeout) const
+    {
+        start();
+        BlockingWaiter waiter;
+        if (!attach(waiter) || waiter.signal.try_acquire_for(timeout))
+        {
+            return std::future_status::ready;
+        }
+        auto expected = tagged(waiter);
+        if (state().compare_exchange_strong(expected, s_running,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return std::future_status::timeout;
+        }
+        // The coroutine finished concurrently and is about to signal
+        // us; the waiter must not go out of scope before that.
+        waiter.signal.acquire();
+        return std::future_status::ready;
+    }
+
+    T get()
+    {
+        wait();
+        return m_handle.promise().take();
+    }
+
+    // ContinuationFuture interface used by co_await.
+    std::coroutine_handle<> set_continuation(
+        std::coroutine_handle<> continuation) const noexcept
+    {
+        const auto address =
+            reinterpret_cast<std::uintptr_t>(continuation.address());
+        auto expected = state().load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (expected == s_ready)
+            {
+                return continuation;
+            }
+            if (expected != s_notStarted && expected != s_running)
+            {
+                // Somebody else waits already.
+                std::terminate();
+            }
+            if (state().compare_exchange_weak(expected, address,
+                    std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                // Run the coroutine on this thread if it was not started,
+                // it transfers to the continuation when it finishes.
+                return expected == s_notStarted ?
+                           std::coroutine_handle<>{m_handle} :
+                           std::noop_coroutine();
+            }
+        }
+    }
+
+    auto operator co_await() && noexcept
+    {
+        return ContinuationFutureAwaiter<lazy_future>{*this};
+    }
+
+private:
+    explicit lazy_future(std::coroutine_handle<promise_type> handle) noexcept
+        : m_handle{handle}
+    {
+    }
+
+    std::atomic<std::uintptr_t>& state() const noexcept
+    {
+        return m_handle.promise().state;
+    }
+
+    static std::uintptr_t tagged(BlockingWaiter& waiter) noexcept
+    {
+        return reinterpret_cast<std::uintptr_t>(&waiter) | s_blockingTag;
+    }
+
+    void start() const
+    {
+        auto expected = s_notStarted;
+        if (state().compare_exchange_strong(expected, s_running,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            m_handle.resume();
+        }
+    }
+
+    // Returns false if the coroutine already finished. Must be called
+    // after start().
+    bool attach(BlockingWaiter& waiter) const noexcept
+    {
+        auto expected = s_running;
+        if (state().compare_exchange_strong(expected, tagged(waiter),
+                std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return true;
+        }
+        if (expected != s_ready)
+        {
+            // Somebody else waits already.
+            std::terminate();
+        }
+        return false;
+    }
+
+    void reset()
+    {
+        if (!m_handle)
+        {
+            return;
+        }
+        // A started coroutine must not be destroyed while it is running.
+        if (state().load(std::memory_order_acquire) != s_notStarted)
+        {
+            wait();
+        }
+        std::exchange(m_handle, nullptr).destroy();
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// Like lazy_future, but copyable and for any number of consumers, like
+// std::shared_future. All of them get a const reference to the same
+// result. The coroutine is started by the first co_await, get() or
+// wait(), the frame is destroyed with the last copy.
+//
+// Every waiter (an awaiting coroutine or a blocked thread) adds a node
+// to an intrusive list headed by the state word. The node lives in the
+// awaiter or on the blocked thread's stack, so waiting does not
+// allocate. There is no wait_for(): a waiter which times out could not
+// unlink its node from the lock-free list.
+//
+// The state word holds one of
+//   s_notStarted, s_ready
+//   the head of the list of waiters while running (nullptr if empty)
+template <typename T>
+class shared_task
+{
+    static constexpr std::uintptr_t s_notStarted = 1;
+    static constexpr std::uintptr_t s_ready = 2;
+
+    struct Waiter
+    {
+        Waiter* next = nullptr;
+        // Resumed when the task finished, blocked threads have none
+        // and are woken with their semaphore.
+        std::coroutine_handle<> continuation;
+        std::binary_semaphore* signal = nullptr;
+    };
+
+    enum class Enqueued
+    {
+        ready,
+        start,
+        waiting
+    };
+
+public:
+    struct promise_type : LazyFutureResult<T>
+    {
+        std::atomic<std::uintptr_t> state = s_notStarted;
+        std::atomic<std::size_t> references = 1;
+
+        shared_task get_return_object() noexcept
+        {
+            DBG;
+            return shared_task{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        auto final_suspend() const noexcept
+        {
+            struct awaiter
+            {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                // Wakes all waiters. All but the last coroutine are
+                // resumed in turn, the last one by symmetric transfer.
+                // The waiters may destroy the task, so the promise is
+                // not touched after the exchange.
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> self) noexcept
+                {
+                    DBG;
+                    auto* waiter = reinterpret_cast<Waiter*>(
+                        self.promise().state.exchange(
+                            s_ready, std::memory_order_acq_rel));
+                    std::coroutine_handle<> next = std::noop_coroutine();
+                    while (waiter != nullptr)
+                    {
+                        auto* following = waiter->next;
+                        if (waiter->continuation)
+                        {
+                            std::exchange(next, waiter->continuation).resume();
+                        }
+                        else
+                        {
+                            waiter->signal->release();
+                        }
+                        waiter = following;
+                    }
+                    return next;
+                }
+
+                void await_resume() const noexcept
+                {
+                }
+            };
+            return awaiter{};
+        }
+
+        void unhandled_exception() noexcept
+        {
+            DBG;
+            this->setException(std::current_exception());
+        }
+    };
+
+    shared_task(const shared_task& other) noexcept
+        : m_handle{other.m_handle}
+    {
+        if (m_handle)
+        {
+            m_handle.promise().references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    shared_task(shared_task&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, nullptr)}
+    {
+    }
+
+    shared_task& operator=(shared_task other) noexcept
+    {
+        std::swap(m_handle, other.m_handle);
+        return *this;
+    }
+
+    ~shared_task()
+    {
+        if (m_handle &&
+            m_handle.promise().references.fetch_sub(
+                1, std::memory_order_acq_rel) == 1)
+        {
+            // Waiters hold copies, so nobody waits for a task which is
+            // still running here; let it finish before destroying it.
+            const auto state = this->state().load(std::memory_order_acquire);
+            if (state != s_notStarted && state != s_ready)
+            {
+                wait();
+            }
+            m_handle.destroy();
+        }
+    }
+
+    bool valid() const noexcept
+    {
+        return static_cast<bool>(m_handle);
+    }
+
+    bool is_ready() const noexcept
+    {
+        return state().load(std::memory_order_acquire) == s_ready;
+    }
+
+    // Blocks until the coroutine finished. Starts it on the calling
+    // thread if nobody did so far.
+    void wait() const
+    {
+        std::binary_semaphore signal{0};
+        Waiter waiter{nullptr, nullptr, &signal};
+        switch (enqueue(waiter))
+        {
+        case Enqueued::ready:
+            return;
+        case Enqueued::start:
+            m_handle.resume();
+            break;
+        case Enqueued::waiting:
+            break;
+        }
+        signal.acquire();
+    }
+
+    decltype(auto) get() const
+    {
+        wait();
+        return m_handle.promise().get();
+    }
+
+    auto operator co_await() const noexcept
+    {
+        struct awaiter : Waiter
+        {
+            const shared_task& task;
+
+            explicit awaiter(const shared_task& t) noexcept
+                : task{t}
+            {
+            }
+
+            bool await_ready() const noexcept
+            {
+                return task.is_ready();
+            }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<> continuation) noexcept
+            {
+                this->continuation = continuation;
+                switch (task.enqueue(*this))
+                {
+                case Enqueued::ready:
+                    return continuation;
+                case Enqueued::start:
+                    return task.m_handle;
+                case Enqueued::waiting:
+                    break;
+                }
+                return std::noop_coroutine();
+            }
+
+            decltype(auto) await_resume() const
+            {
+                return task.m_handle.promise().get();
+            }
+        };
+        return awaiter{*this};
+    }
+
+private:
+    explicit shared_task(std::coroutine_handle<promise_type> handle) noexcept
+        : m_handle{handle}
+    {
+    }
+
+    std::atomic<std::uintptr_t>& state() const noexcept
+    {
+        return m_handle.promise().state;
+    }
+
+    // Pushes waiter unless the task is ready. The caller has to start
+    // the coroutine if it was not started yet.
+    Enqueued enqueue(Waiter& waiter) const noexcept
+    {
+        auto expected = state().load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (expected == s_ready)
+            {
+                return Enqueued::ready;
+            }
+            waiter.next = expected == s_notStarted ?
+                              nullptr :
+                              reinterpret_cast<Waiter*>(expected);
+            if (state().compare_exchange_weak(expected,
+                    reinterpret_cast<std::uintptr_t>(&waiter),
+                    std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return expected == s_notStarted ? Enqueued::start :
+                                                  Enqueued::waiting;
+            }
+        }
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
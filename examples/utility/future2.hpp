@@ -6,6 +6,7 @@
 #include <thread>
 #include <type_traits>
 #include "trace.hpp"
+#include "future_poller.hpp"
 // A program-defined type on which the coroutine_traits specializations
 // below depend
 struct as_coroutine
@@ -94,35 +95,49 @@ struct std::coroutine_traits<std::future<void>, as_coroutine, Args...>
     };
 };
 
-// Allow co_await'ing std::future<T> and std::future<void>
-// by naively spawning a new thread for each co_await.
+// Allow co_await'ing std::future<T> and std::future<void>. Instead of
+// spawning a thread per co_await, the awaiter registers itself with
+// the shared FuturePoller which watches all pending futures on one
+// thread.
 template <typename T>
 auto operator co_await(std::future<T> future) noexcept
 {
-    struct awaiter
+    struct awaiter : FuturePoller::Waiter
     {
         std::future<T> future;
+
+        explicit awaiter(std::future<T>&& f) noexcept
+            : FuturePoller::Waiter{&awaiter::isFutureReady}
+            , future{std::move(f)}
+        {
+        }
+
         bool await_ready() const noexcept
         {
             DBG;
             using namespace std::chrono_literals;
             return future.wait_for(0s) != std::future_status::timeout;
         }
-        void await_suspend(std::coroutine_handle<> cont) const
+        void await_suspend(std::coroutine_handle<> cont)
         {
             DBG;
-            std::thread([this, cont] {
-                DBG;
-                future.wait();
-                cont();
-            }).detach();
-            DBG;
+            // The awaiter lives in the suspended coroutine's frame, so
+            // the poller can refer to it until it resumes cont.
+            continuation = cont;
+            FuturePoller::instance().watch(*this);
         }
         T await_resume()
         {
             DBG;
             return future.get();
         }
+
+        static bool isFutureReady(FuturePoller::Waiter& waiter) noexcept
+        {
+            using namespace std::chrono_literals;
+            return static_cast<awaiter&>(waiter).future.wait_for(0s) !=
+                   std::future_status::timeout;
+        }
     };
     return awaiter{std::move(future)};
 }
@@ -0,0 +1,178 @@
+// A single thread which watches many std::future objects at once and
+// resumes the coroutines waiting on them. std::future has no way to
+// register a callback, so the futures are polled with wait_for(0s)
+// with an exponential backoff while nothing becomes ready.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+class FuturePoller
+{
+public:
+    // Intrusive node which lives inside the awaiter (i.e. in the
+    // coroutine frame of the waiting coroutine), so watching a future
+    // does not allocate.
+    struct Waiter
+    {
+        explicit Waiter(bool (*ready)(Waiter&) noexcept) noexcept
+            : isReady{ready}
+        {
+        }
+
+        bool (*isReady)(Waiter&) noexcept = nullptr;
+        std::coroutine_handle<> continuation;
+        Waiter* next = nullptr;
+    };
+
+    static FuturePoller& instance()
+    {
+        static FuturePoller poller;
+        return poller;
+    }
+
+    FuturePoller()
+        : m_thread([this] { run(); })
+    {
+    }
+
+    ~FuturePoller()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_one();
+        m_thread.join();
+    }
+
+    FuturePoller(const FuturePoller&) = delete;
+
+    FuturePoller& operator=(const FuturePoller&) = delete;
+
+    // Resumes waiter.continuation on the poller thread once
+    // waiter.isReady returns true. The waiter must stay alive until
+    // then.
+    void watch(Waiter& waiter)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            waiter.next = m_incoming;
+            m_incoming = &waiter;
+        }
+        m_cond.notify_one();
+    }
+
+private:
+    static constexpr std::chrono::microseconds s_minBackoff{50};
+    static constexpr std::chrono::microseconds s_maxBackoff{2000};
+
+    void run()
+    {
+        Waiter* pending = nullptr;
+        auto backoff = s_minBackoff;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop)
+        {
+            const auto hasWork = [this] { return m_stop || m_incoming; };
+            if (pending == nullptr)
+            {
+                m_cond.wait(lock, hasWork);
+            }
+            else
+            {
+                m_cond.wait_for(lock, backoff, hasWork);
+            }
+            if (m_stop)
+            {
+                break;
+            }
+
+            while (m_incoming != nullptr)
+            {
+                auto* waiter = std::exchange(m_incoming, m_incoming->next);
+                waiter->next = pending;
+                pending = waiter;
+            }
+            lock.unlock();
+
+            // Unlink all ready waiters first and resume them afterwards,
+            // a resumed coroutine may destroy its waiter.
+            Waiter* ready = nullptr;
+            for (Waiter** link = &pending; *link != nullptr;)
+            {
+                auto* waiter = *link;
+                if (waiter->isReady(*waiter))
+                {
+                    *link = waiter->next;
+                    waiter->next = ready;
+                    ready = waiter;
+                }
+                else
+                {
+                    link = &waiter->next;
+                }
+            }
+
+            backoff =
+                ready ? s_minBackoff : std::min(backoff * 2, s_maxBackoff);
+
+            while (ready != nullptr)
+            {
+                auto continuation = ready->continuation;
+                ready = ready->next;
+                continuation.resume();
+            }
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    Waiter* m_incoming = nullptr;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+// Futures which resume a continuation themselves when the result is
+// set do not need the poller. set_continuation returns the coroutine to
+// run next: the continuation itself if the result is already
+// available, the producing coroutine if it still has to be started or
+// std::noop_coroutine() if the continuation will be resumed later.
+template <typename F>
+concept ContinuationFuture = requires(F& f, std::coroutine_handle<> h) {
+    { f.is_ready() } -> std::convertible_to<bool>;
+    {
+        f.set_continuation(h)
+    } -> std::convertible_to<std::coroutine_handle<>>;
+    f.get();
+};
+
+template <ContinuationFuture F>
+struct ContinuationFutureAwaiter
+{
+    F& future;
+
+    bool await_ready() const noexcept
+    {
+        return future.is_ready();
+    }
+
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> continuation)
+    {
+        return future.set_continuation(continuation);
+    }
+
+    decltype(auto) await_resume()
+    {
+        return future.get();
+    }
+};
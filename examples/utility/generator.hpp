@@ -3,15 +3,21 @@
 #pragma once
 
 #include "trace.hpp"
+#include "frame_cache.hpp"
+#include <array>
 #include <iostream>
 #include <coroutine>
+#include <exception>
+#include <iterator>
+#include <span>
 #include <type_traits>
 #include <utility>
+#include <variant>
 
 template <typename T>
 struct Generator
 {
-    struct promise_type
+    struct promise_type : RecyclingFrame
     {
         auto get_return_object() noexcept
         {
@@ -81,11 +87,15 @@ struct Generator
     Generator& operator=(Generator&& other) noexcept
     {
         DBG;
-        if (handle)
+        if (this != &other)
         {
-            handle.destory();
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
         }
-        handle = std::exchange(other.handle, nullptr);
+        return *this;
     }
 
     ~Generator()
@@ -115,7 +125,7 @@ private:
 template <typename T>
 struct ImprovedGenerator
 {
-    struct promise_type
+    struct promise_type : RecyclingFrame
     {
         auto get_return_object() noexcept
         {
@@ -175,8 +185,11 @@ struct ImprovedGenerator
             {
                 std::rethrow_exception(std::get<std::exception_ptr>(result));
             }
-            return std::get<T>(result) ? std::get<T>(result) :
-                                         *std::get<T*>(result);
+            if (auto* pointer = std::get_if<T*>(&result))
+            {
+                return **pointer;
+            }
+            return std::get<T>(result);
         }
 
         bool hasException() const noexcept
@@ -198,11 +211,15 @@ struct ImprovedGenerator
     ImprovedGenerator& operator=(ImprovedGenerator&& other) noexcept
     {
         DBG;
-        if (handle)
+        if (this != &other)
         {
-            handle.destory();
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
         }
-        handle = std::exchange(other.handle, nullptr);
+        return *this;
     }
 
     ~ImprovedGenerator()
@@ -237,7 +254,7 @@ private:
 template <typename T>
 struct IterableGenerator
 {
-    struct promise_type
+    struct promise_type : RecyclingFrame
     {
         auto get_return_object() noexcept
         {
@@ -298,8 +315,11 @@ struct IterableGenerator
         T& getValue() noexcept
         {
             DBG;
-            return std::get<T>(result) ? std::get<T>(result) :
-                                         *std::get<T*>(result);
+            if (auto* pointer = std::get_if<T*>(&result))
+            {
+                return **pointer;
+            }
+            return std::get<T>(result);
         }
 
         bool hasException() const noexcept
@@ -323,8 +343,9 @@ struct IterableGenerator
     struct Iterator
     {
         using iterator_category = std::input_iterator_tag;
-        using difference_type = std::ptrdiff_t; // does't make sense
-                                                // for inputer iterator
+        // Not meaningful for a single pass iterator, but required by
+        // std::weakly_incrementable.
+        using difference_type = std::ptrdiff_t;
         using value_type = T;
         using reference = T&;
         using pointer = T*;
@@ -368,11 +389,15 @@ struct IterableGenerator
     IterableGenerator& operator=(IterableGenerator&& other) noexcept
     {
         DBG;
-        if (handle)
+        if (this != &other)
         {
-            handle.destory();
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
         }
-        handle = std::exchange(other.handle, nullptr);
+        return *this;
     }
 
     ~IterableGenerator()
@@ -420,3 +445,461 @@ private:
 
     std::coroutine_handle<promise_type> handle;
 };
+
+// Generator which hands out its values in batches of up to N elements.
+// co_yield only writes into a buffer inside the coroutine frame and
+// the coroutine is suspended when the buffer is full, so the cost of a
+// resume is shared by N elements. Iterating is a pointer bump within
+// the current batch. T has to be default constructible.
+template <typename T, std::size_t N = 64>
+struct BatchedGenerator
+{
+    static_assert(N > 0, "Batch size has to be positive");
+
+    struct promise_type : RecyclingFrame
+    {
+        auto get_return_object() noexcept
+        {
+            DBG;
+            return BatchedGenerator{*this};
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        std::suspend_always final_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        // Only suspends if the batch is full, otherwise the coroutine
+        // continues to produce the next element right away.
+        struct BatchAwaiter
+        {
+            bool full;
+
+            bool await_ready() const noexcept
+            {
+                return !full;
+            }
+
+            void await_suspend(std::coroutine_handle<>) const noexcept
+            {
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        template <typename U>
+        BatchAwaiter yield_value(U&& value) noexcept(
+            std::is_nothrow_assignable_v<T&, U&&>)
+        {
+            buffer[count++] = std::forward<U>(value);
+            return {count == N};
+        }
+
+        void return_void() const noexcept
+        {
+            DBG;
+        };
+
+        void unhandled_exception() noexcept
+        {
+            DBG;
+            exception = std::current_exception();
+        }
+
+        std::array<T, N> buffer;
+        std::size_t count = 0;
+        std::exception_ptr exception;
+    };
+
+    struct Iterator
+    {
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = T&;
+        using pointer = T*;
+
+        Iterator() noexcept = default;
+        explicit Iterator(BatchedGenerator& gen)
+            : generator{&gen}
+        {
+            refill();
+        }
+
+        friend bool operator==(
+            const Iterator& lhs, const Iterator& rhs) noexcept
+        {
+            return lhs.current == rhs.current;
+        }
+
+        Iterator& operator++()
+        {
+            if (++current == last)
+            {
+                refill();
+            }
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            ++*this;
+        }
+
+        T& operator*() const noexcept
+        {
+            return *current;
+        }
+
+        T* operator->() const noexcept
+        {
+            return current;
+        }
+
+    private:
+        void refill()
+        {
+            const auto batch = generator->nextBatch();
+            current = batch.empty() ? nullptr : batch.data();
+            last = batch.empty() ? nullptr : batch.data() + batch.size();
+        }
+
+        BatchedGenerator* generator = nullptr;
+        T* current = nullptr;
+        T* last = nullptr;
+    };
+
+    BatchedGenerator(BatchedGenerator&& other) noexcept
+        : handle{std::exchange(other.handle, nullptr)}
+    {
+        DBG;
+    }
+
+    BatchedGenerator& operator=(BatchedGenerator&& other) noexcept
+    {
+        DBG;
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~BatchedGenerator()
+    {
+        DBG;
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    // Resumes the coroutine until it filled the next batch or finished.
+    // Returns an empty span once the generator is exhausted. The span
+    // is valid until the next call. Elements produced before an
+    // exception are returned first, the exception is thrown by the
+    // following call.
+    std::span<T> nextBatch()
+    {
+        auto& promise = handle.promise();
+        if (promise.exception)
+        {
+            std::rethrow_exception(std::exchange(promise.exception, nullptr));
+        }
+        if (handle.done())
+        {
+            return {};
+        }
+        promise.count = 0;
+        handle.resume();
+        if (promise.exception && promise.count == 0)
+        {
+            std::rethrow_exception(std::exchange(promise.exception, nullptr));
+        }
+        return {promise.buffer.data(), promise.count};
+    }
+
+    Iterator begin()
+    {
+        return Iterator{*this};
+    }
+
+    Iterator end() const noexcept
+    {
+        return {};
+    }
+
+private:
+    explicit BatchedGenerator(promise_type& promise) noexcept
+        : handle{std::coroutine_handle<promise_type>::from_promise(promise)}
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Generator which can co_yield another RecursiveGenerator; the elements
+// of the nested generator are produced as if they were yielded by the
+// outer one. The promise of the outermost (root) generator keeps track
+// of the innermost active (leaf) generator and the consumer resumes
+// the leaf directly. Producing an element therefore costs one resume
+// independent of the nesting depth, instead of one resume per level
+// when every level re-yields the elements of its child.
+template <typename T>
+struct RecursiveGenerator
+{
+    struct promise_type : RecyclingFrame
+    {
+        auto get_return_object() noexcept
+        {
+            DBG;
+            return RecursiveGenerator{*this};
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        std::suspend_always final_suspend() const noexcept
+        {
+            DBG;
+            return {};
+        }
+
+        std::suspend_always yield_value(T& value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        // The temporary lives in the coroutine frame until the coroutine
+        // is resumed, so it is safe to hand out a pointer to it.
+        std::suspend_always yield_value(T&& value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        // Suspends the current generator and makes child the new leaf.
+        // The awaiter resumes once child is exhausted and rethrows its
+        // exception, if any.
+        auto yield_value(RecursiveGenerator& child) noexcept
+        {
+            struct awaiter
+            {
+                promise_type* child;
+
+                bool await_ready() const noexcept
+                {
+                    return child == nullptr || child->isComplete();
+                }
+
+                void await_suspend(std::coroutine_handle<>) const noexcept
+                {
+                }
+
+                void await_resume() const
+                {
+                    if (child != nullptr)
+                    {
+                        child->throwIfException();
+                    }
+                }
+            };
+
+            if (!child.handle)
+            {
+                return awaiter{nullptr};
+            }
+            auto* childPromise = &child.handle.promise();
+            childPromise->root = root;
+            childPromise->parentOrLeaf = this;
+            root->parentOrLeaf = childPromise;
+            childPromise->resume();
+            if (childPromise->isComplete())
+            {
+                // Child did not produce anything, continue with this one.
+                // The awaiter is ready and still rethrows if the child
+                // failed before its first co_yield.
+                root->parentOrLeaf = this;
+            }
+            return awaiter{childPromise};
+        }
+
+        auto yield_value(RecursiveGenerator&& child) noexcept
+        {
+            return yield_value(child);
+        }
+
+        void return_void() const noexcept
+        {
+            DBG;
+        };
+
+        void unhandled_exception() noexcept
+        {
+            DBG;
+            exception = std::current_exception();
+        }
+
+        void throwIfException()
+        {
+            if (exception)
+            {
+                std::rethrow_exception(std::exchange(exception, nullptr));
+            }
+        }
+
+        bool isComplete() const noexcept
+        {
+            return std::coroutine_handle<promise_type>::from_promise(
+                const_cast<promise_type&>(*this))
+                .done();
+        }
+
+        void resume()
+        {
+            std::coroutine_handle<promise_type>::from_promise(*this).resume();
+        }
+
+        // Only called on the root. Resumes the leaf; every exhausted
+        // leaf hands control back to its parent.
+        void pull()
+        {
+            parentOrLeaf->resume();
+            while (parentOrLeaf != this && parentOrLeaf->isComplete())
+            {
+                parentOrLeaf = parentOrLeaf->parentOrLeaf;
+                parentOrLeaf->resume();
+            }
+        }
+
+        T& value() const noexcept
+        {
+            return *parentOrLeaf->current;
+        }
+
+    private:
+        promise_type* root = this;
+        // For the root: the current leaf. Otherwise: the parent.
+        promise_type* parentOrLeaf = this;
+        T* current = nullptr;
+        std::exception_ptr exception;
+    };
+
+    struct Iterator
+    {
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_cv_t<T>;
+        using reference = T&;
+        using pointer = T*;
+
+        Iterator() noexcept = default;
+        explicit Iterator(std::coroutine_handle<promise_type> coro) noexcept
+            : handle{coro}
+        {
+        }
+
+        friend bool operator==(
+            const Iterator&, const Iterator&) noexcept = default;
+
+        Iterator& operator++()
+        {
+            handle.promise().pull();
+            if (handle.done())
+            {
+                std::exchange(handle, nullptr).promise().throwIfException();
+            }
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            ++*this;
+        }
+
+        T& operator*() const noexcept
+        {
+            return handle.promise().value();
+        }
+
+        T* operator->() const noexcept
+        {
+            return std::addressof(operator*());
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    RecursiveGenerator() noexcept = default;
+
+    RecursiveGenerator(RecursiveGenerator&& other) noexcept
+        : handle{std::exchange(other.handle, nullptr)}
+    {
+        DBG;
+    }
+
+    RecursiveGenerator& operator=(RecursiveGenerator&& other) noexcept
+    {
+        DBG;
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~RecursiveGenerator()
+    {
+        DBG;
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    Iterator begin()
+    {
+        if (!handle)
+        {
+            return end();
+        }
+        auto i = Iterator{handle};
+        ++i;
+        return i;
+    }
+
+    Iterator end() const noexcept
+    {
+        return {};
+    }
+
+private:
+    explicit RecursiveGenerator(promise_type& promise) noexcept
+        : handle{std::coroutine_handle<promise_type>::from_promise(promise)}
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
@@ -0,0 +1,97 @@
+// Owning callables for queues of jobs and stored callbacks, built on
+// basic_any_of (see any_of.hpp):
+//
+//  - move_only_function<Sig, SBOSize> stores callables of up to SBOSize
+//    bytes inline and allocates larger ones.
+//  - inplace_function<Sig, Capacity> never allocates. A callable which
+//    does not fit into Capacity bytes does not compile.
+//
+// Unlike std::function both accept move-only callables (e.g. a lambda
+// which captures a unique_ptr) and are move-only themselves. A call
+// loads the function pointer from the static vtable and calls it with
+// the inline object, there is no heap object in between.
+
+#pragma once
+
+#include "any_of.hpp"
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature>
+struct invocable_interface;
+
+template <typename R, typename... Args>
+struct invocable_interface<R(Args...)>
+{
+    R (*invoke)(void* self, Args... args);
+
+    template <typename T>
+    static constexpr invocable_interface vtable_for = {
+        [](void* self, Args... args) -> R {
+            if constexpr (std::is_void_v<R>)
+            {
+                std::invoke(*static_cast<T*>(self), std::forward<Args>(args)...);
+            }
+            else
+            {
+                return std::invoke(
+                    *static_cast<T*>(self), std::forward<Args>(args)...);
+            }
+        }};
+};
+
+template <typename Signature, std::size_t SBOSize, bool AllowHeap>
+class basic_function;
+
+template <typename R, typename... Args, std::size_t SBOSize, bool AllowHeap>
+class basic_function<R(Args...), SBOSize, AllowHeap>
+{
+    using Interface = invocable_interface<R(Args...)>;
+    using Storage = basic_any_of<Interface, SBOSize>;
+
+public:
+    basic_function() noexcept = default;
+
+    basic_function(std::nullptr_t) noexcept
+    {
+    }
+
+    template <typename F>
+        requires(!std::is_same_v<std::decay_t<F>, basic_function> &&
+                 std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    basic_function(F&& f)
+        : m_callable{std::forward<F>(f)}
+    {
+        static_assert(AllowHeap || Storage::template fitsInline<std::decay_t<F>>(),
+            "The callable does not fit into the inplace_function");
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(m_callable);
+    }
+
+    // True if the callable is stored without a heap allocation.
+    bool isInline() const noexcept
+    {
+        return m_callable.isInline();
+    }
+
+    // Must not be called when empty.
+    R operator()(Args... args)
+    {
+        return m_callable.template call<&Interface::invoke>(
+            std::forward<Args>(args)...);
+    }
+
+private:
+    Storage m_callable;
+};
+
+template <typename Signature, std::size_t SBOSize = 32>
+using move_only_function = basic_function<Signature, SBOSize, true>;
+
+template <typename Signature, std::size_t Capacity = 32>
+using inplace_function = basic_function<Signature, Capacity, false>;
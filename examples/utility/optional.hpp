@@ -1,11 +1,30 @@
+// Coroutine support for std::optional. In a coroutine which returns
+// std::optional<T>, co_await on an optional yields its value or, if it
+// is empty, ends the coroutine with an empty result:
+//
+//   std::optional<int> test(std::optional<int> a, std::optional<int> b)
+//   {
+//       co_return (co_await a) * (co_await b);
+//   }
+//
+// The coroutine never suspends. It is finished or destroyed before it
+// returns to its caller, so the frame does not outlive the call and
+// compilers with heap allocation elision (Clang) can put it on the
+// caller's stack once the coroutine is inlined. Where that does not
+// happen the frame comes from a FrameBuffer of the caller if there is
+// one (see frame_cache.hpp), otherwise from the heap.
+
 #pragma once
 
+#include "frame_cache.hpp"
 #include "trace.hpp"
 #include <iostream>
 #include <coroutine>
 #include <optional>
 #include <source_location>
 #include <thread>
+#include <type_traits>
+#include <utility>
 
 
 // OptionalHolder is returned as proxy class from
@@ -23,15 +42,44 @@ struct OptionalHolder
 
     OptionalHolder(OptionalHolder const&) = delete;
 
-    operator std::optional<T>() const noexcept
+    operator std::optional<T>() noexcept
     {
-        std::cout << "doing implicit conversion of result.\n";
         return std::move(optional);
     }
 };
 
+// Result is a reference for awaited lvalues, which are left untouched,
+// and a value moved out of the optional for awaited rvalues.
+template <typename Optional, typename Result>
+struct OptionalAwaiter
+{
+    Optional* value;
+
+    bool await_ready() const noexcept
+    {
+        return value->has_value();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const noexcept
+    {
+        handle.destroy();
+    }
+
+    Result await_resume() const noexcept
+    {
+        if constexpr (std::is_reference_v<Result>)
+        {
+            return **value;
+        }
+        else
+        {
+            return std::move(**value);
+        }
+    }
+};
+
 template <typename T>
-struct OptionalPromise
+struct OptionalPromise : StackedFrame
 {
     std::optional<T>* optional = nullptr;
 
@@ -50,9 +98,10 @@ struct OptionalPromise
         return {};
     }
 
-    void return_value(const T& val) noexcept
+    template <typename U = T>
+    void return_value(U&& val)
     {
-        *optional = val;
+        optional->emplace(std::forward<U>(val));
     }
 
     void unhandled_exception()
@@ -60,28 +109,21 @@ struct OptionalPromise
     }
 
     template <typename U>
-    auto await_transform(std::optional<U>& value)
+    auto await_transform(std::optional<U>& value) noexcept
     {
-        struct awaiter
-        {
-            const std::optional<U>* value;
-
-            bool await_ready() noexcept
-            {
-                return value->has_value();
-            }
-
-            void await_suspend(std::coroutine_handle<> handle) noexcept
-            {
-                handle.destroy();
-            }
-
-            U await_resume() noexcept
-            {
-                return **value;
-            };
-        };
-        return awaiter{&value};
+        return OptionalAwaiter<std::optional<U>, U&>{&value};
+    }
+
+    template <typename U>
+    auto await_transform(const std::optional<U>& value) noexcept
+    {
+        return OptionalAwaiter<const std::optional<U>, const U&>{&value};
+    }
+
+    template <typename U>
+    auto await_transform(std::optional<U>&& value) noexcept
+    {
+        return OptionalAwaiter<std::optional<U>, U>{&value};
     }
 };
 
@@ -93,4 +135,3 @@ struct coroutine_traits<std::optional<T>, ARGS...>
     using promise_type = OptionalPromise<T>;
 };
 } // namespace std
-
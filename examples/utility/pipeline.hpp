@@ -0,0 +1,315 @@
+// Runs the elements of a generator (or any other input range) through a
+// chain of stages, every stage on its own worker thread(s):
+//
+//   pipeline(gen) | stage(parse) | stage(transform, 4) | sink(aggregate);
+//
+// Stages are connected by bounded lock-free single-producer
+// single-consumer ring buffers. All stages work concurrently, so the
+// throughput is limited by the slowest stage rather than by the sum of
+// all stages. A stage with n threads is fed round-robin: element k is
+// processed by worker k % n. Every pair of upstream worker i and
+// downstream worker j has its own channel, so every channel keeps a
+// single producer and a single consumer, and reading round-robin on the
+// other side restores the original order.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bounded single-producer single-consumer queue. Each side keeps a
+// private copy of the other side's index and only reloads it when the
+// ring looks full (empty), so in the common case push and pop touch no
+// cache line written by the other thread. A blocked side sleeps with
+// atomic wait. The closed flag is stored in bit 0 of the head counter,
+// so a waiting consumer is woken by close() as well.
+template <typename T, std::size_t Capacity = 1024>
+class SpscChannel
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity has to be a power of two");
+
+public:
+    void push(T value)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        const auto index = head >> 1;
+        while (index - m_cachedTail == Capacity)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (index - m_cachedTail == Capacity)
+            {
+                m_tail.wait(m_cachedTail, std::memory_order_acquire);
+            }
+        }
+        m_buffer[index & s_mask].emplace(std::move(value));
+        m_head.store(head + 2, std::memory_order_release);
+        m_head.notify_one();
+    }
+
+    // No push after close.
+    void close()
+    {
+        m_head.fetch_or(1, std::memory_order_release);
+        m_head.notify_one();
+    }
+
+    // Returns std::nullopt once the channel is closed and drained.
+    std::optional<T> pop()
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        while (tail == m_cachedHead)
+        {
+            const auto head = m_head.load(std::memory_order_acquire);
+            m_cachedHead = head >> 1;
+            if (tail != m_cachedHead)
+            {
+                break;
+            }
+            if (head & 1)
+            {
+                return std::nullopt;
+            }
+            m_head.wait(head, std::memory_order_acquire);
+        }
+        auto& slot = m_buffer[tail & s_mask];
+        std::optional<T> value{std::move(slot)};
+        slot.reset();
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_tail.notify_one();
+        return value;
+    }
+
+private:
+    static constexpr std::size_t s_mask = Capacity - 1;
+    static constexpr std::size_t s_cacheLine = 64;
+
+    std::optional<T> m_buffer[Capacity];
+    // Written by the producer: element count << 1 | closed.
+    alignas(s_cacheLine) std::atomic<std::size_t> m_head = 0;
+    std::size_t m_cachedTail = 0;
+    // Written by the consumer.
+    alignas(s_cacheLine) std::atomic<std::size_t> m_tail = 0;
+    std::size_t m_cachedHead = 0;
+};
+
+// producers x consumers channels between two pipeline stages.
+template <typename T>
+class StageLink
+{
+public:
+    StageLink(std::size_t producers, std::size_t consumers)
+        : m_producers{producers}
+        , m_consumers{consumers}
+    {
+        m_channels.reserve(producers * consumers);
+        for (std::size_t i = 0; i < producers * consumers; ++i)
+        {
+            m_channels.push_back(std::make_unique<SpscChannel<T>>());
+        }
+    }
+
+    // Used by upstream worker `producer`.
+    class Writer
+    {
+    public:
+        Writer(StageLink& link, std::size_t producer)
+            : m_link{link}
+            , m_producer{producer}
+        {
+        }
+
+        void push(T value)
+        {
+            // This worker handles the elements producer + n * producers.
+            const auto sequence = m_producer + m_count++ * m_link.m_producers;
+            m_link.at(m_producer, sequence % m_link.m_consumers)
+                .push(std::move(value));
+        }
+
+        void close()
+        {
+            for (std::size_t c = 0; c < m_link.m_consumers; ++c)
+            {
+                m_link.at(m_producer, c).close();
+            }
+        }
+
+    private:
+        StageLink& m_link;
+        std::size_t m_producer;
+        std::size_t m_count = 0;
+    };
+
+    // Used by downstream worker `consumer`.
+    class Reader
+    {
+    public:
+        Reader(StageLink& link, std::size_t consumer)
+            : m_link{link}
+            , m_consumer{consumer}
+            , m_sequence{consumer}
+        {
+        }
+
+        std::optional<T> pop()
+        {
+            auto value = m_link.at(m_sequence % m_link.m_producers, m_consumer)
+                             .pop();
+            m_sequence += m_link.m_consumers;
+            return value;
+        }
+
+    private:
+        StageLink& m_link;
+        std::size_t m_consumer;
+        std::size_t m_sequence;
+    };
+
+private:
+    SpscChannel<T>& at(std::size_t producer, std::size_t consumer)
+    {
+        return *m_channels[producer * m_consumers + consumer];
+    }
+
+    std::size_t m_producers;
+    std::size_t m_consumers;
+    std::vector<std::unique_ptr<SpscChannel<T>>> m_channels;
+};
+
+template <typename Range>
+class PipelineSource
+{
+public:
+    using value_type =
+        std::remove_cvref_t<decltype(*std::begin(std::declval<Range&>()))>;
+
+    explicit PipelineSource(Range range)
+        : m_range{std::move(range)}
+    {
+    }
+
+    // Starts the thread which iterates the range and returns the link
+    // it writes to.
+    std::shared_ptr<StageLink<value_type>> start(
+        std::size_t consumers, std::vector<std::jthread>& threads)
+    {
+        auto link = std::make_shared<StageLink<value_type>>(1, consumers);
+        threads.emplace_back([range = std::move(m_range), link]() mutable {
+            typename StageLink<value_type>::Writer writer{*link, 0};
+            for (auto&& value : range)
+            {
+                writer.push(std::forward<decltype(value)>(value));
+            }
+            writer.close();
+        });
+        return link;
+    }
+
+private:
+    Range m_range;
+};
+
+template <typename F>
+struct StageSpec
+{
+    F function;
+    std::size_t threads;
+};
+
+template <typename F>
+struct SinkSpec
+{
+    F function;
+};
+
+template <typename Upstream, typename F>
+class PipelineStage
+{
+public:
+    using input_type = typename Upstream::value_type;
+    using value_type = std::invoke_result_t<F&, input_type&&>;
+
+    PipelineStage(Upstream upstream, StageSpec<F> spec)
+        : m_upstream{std::move(upstream)}
+        , m_spec{std::move(spec)}
+    {
+    }
+
+    std::shared_ptr<StageLink<value_type>> start(
+        std::size_t consumers, std::vector<std::jthread>& threads)
+    {
+        const auto workers = m_spec.threads;
+        auto in = m_upstream.start(workers, threads);
+        auto out = std::make_shared<StageLink<value_type>>(workers, consumers);
+        for (std::size_t i = 0; i < workers; ++i)
+        {
+            threads.emplace_back([in, out, f = m_spec.function, i]() mutable {
+                typename StageLink<input_type>::Reader reader{*in, i};
+                typename StageLink<value_type>::Writer writer{*out, i};
+                while (auto value = reader.pop())
+                {
+                    writer.push(std::invoke(f, std::move(*value)));
+                }
+                writer.close();
+            });
+        }
+        return out;
+    }
+
+private:
+    Upstream m_upstream;
+    StageSpec<F> m_spec;
+};
+
+template <typename Range>
+auto pipeline(Range&& range)
+{
+    return PipelineSource<std::remove_cvref_t<Range>>{
+        std::forward<Range>(range)};
+}
+
+// f is called with each element; runs on threads worker threads.
+template <typename F>
+auto stage(F f, std::size_t threads = 1)
+{
+    return StageSpec<F>{std::move(f), threads == 0 ? 1 : threads};
+}
+
+// f is called with each element in order on the calling thread.
+template <typename F>
+auto sink(F f)
+{
+    return SinkSpec<F>{std::move(f)};
+}
+
+template <typename Upstream, typename F>
+auto operator|(Upstream upstream, StageSpec<F> spec)
+    -> PipelineStage<Upstream, F>
+{
+    return {std::move(upstream), std::move(spec)};
+}
+
+// Starts all stages, feeds the results to the sink and blocks until the
+// source is exhausted.
+template <typename Upstream, typename F>
+auto operator|(Upstream upstream, SinkSpec<F> spec)
+    -> decltype(upstream.start(1, std::declval<std::vector<std::jthread>&>()),
+        void())
+{
+    std::vector<std::jthread> threads;
+    auto link = upstream.start(1, threads);
+    typename StageLink<typename Upstream::value_type>::Reader reader{*link, 0};
+    while (auto value = reader.pop())
+    {
+        std::invoke(spec.function, std::move(*value));
+    }
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <iostream>
 #include <source_location>
+#include <thread>
 
 #if !defined(__PRETTY_FUNCTION__) && !defined(__GNUC__)
 #define __PRETTY_FUNCTION__ __FUNCSIG__
@@ -1,8 +1,20 @@
+#include <algorithm>
 #include <array>
+#include <boost/stl_interfaces/iterator_interface.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <string>
+#include <variant>
 #include <vector>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 template <typename... T>
 struct mp_list {};
@@ -122,6 +134,970 @@ using unpack = typename T::type;
 template <typename T>
 using add_pointer = T*;
 
+// The algorithms below avoid recursing over the elements of a list. A
+// list of N types needs N nested instantiations with a naive recursive
+// implementation, which hits -ftemplate-depth and gets slow for lists
+// of a few hundred types. Instead they
+//  - index with __type_pack_element where available and otherwise
+//    with overload resolution against an inherited set of indexed bases,
+//  - compute the positions of the selected elements with a constexpr
+//    function and pick them in a single pack expansion,
+//  - split lists in halves where recursion is needed (mp_unique,
+//    mp_sort), so the recursion depth is O(log N).
+//
+// Compile time benchmark, see the end of this file:
+//   g++ -std=c++20 -fsyntax-only -ftime-report -DTYPE_LIST_BENCHMARK type_list.cpp
+//   clang++ -std=c++20 -fsyntax-only -ftime-trace -DTYPE_LIST_BENCHMARK type_list.cpp
+// A small -ftemplate-depth (e.g. 64) shows the depth bound;
+// -DTYPE_LIST_NAIVE replaces mp_at and mp_find with the linear
+// recursion, which needs a depth of ~N.
+
+// Identity
+template <typename T>
+struct mp_identity
+{
+    using type = T;
+};
+
+// Iota: mp_list<integral_constant<0>, ..., integral_constant<N-1>>
+template <std::size_t... I>
+mp_list<std::integral_constant<std::size_t, I>...> mp_iota_fn(
+    std::index_sequence<I...>);
+
+template <std::size_t N>
+using mp_iota_c = decltype(mp_iota_fn(std::make_index_sequence<N>{}));
+
+// Append (recurses over the lists, not over their elements)
+template <typename... L>
+struct mp_append_impl;
+
+template <template <typename...> typename L, typename... T>
+struct mp_append_impl<L<T...>>
+{
+    using type = L<T...>;
+};
+
+template <template <typename...> typename L, typename... T, typename... U,
+          typename... R>
+struct mp_append_impl<L<T...>, L<U...>, R...>
+{
+    using type = typename mp_append_impl<L<T..., U...>, R...>::type;
+};
+
+template <typename... L>
+using mp_append = typename mp_append_impl<L...>::type;
+
+// At
+#if defined(__has_builtin)
+#if __has_builtin(__type_pack_element)
+#define MP_HAS_TYPE_PACK_ELEMENT
+#endif
+#endif
+
+// Inherits mp_indexed<I, T> for every element T at position I.
+template <std::size_t I, typename T>
+struct mp_indexed
+{
+};
+
+template <typename S, typename... T>
+struct mp_indexer;
+
+template <std::size_t... I, typename... T>
+struct mp_indexer<std::index_sequence<I...>, T...> : mp_indexed<I, T>...
+{
+};
+
+// Only the base with index I matches; T is deduced from it.
+template <std::size_t I, typename T>
+mp_identity<T> mp_select_indexed(const mp_indexed<I, T>&);
+
+template <typename L, std::size_t I>
+struct mp_at_c_impl;
+
+#if defined(TYPE_LIST_NAIVE)
+
+template <template <typename...> typename L, typename T1, typename... T,
+          std::size_t I>
+struct mp_at_c_impl<L<T1, T...>, I>
+{
+    using type = typename mp_at_c_impl<L<T...>, I - 1>::type;
+};
+
+template <template <typename...> typename L, typename T1, typename... T>
+struct mp_at_c_impl<L<T1, T...>, 0>
+{
+    using type = T1;
+};
+
+#elif defined(MP_HAS_TYPE_PACK_ELEMENT)
+
+template <template <typename...> typename L, typename... T, std::size_t I>
+struct mp_at_c_impl<L<T...>, I>
+{
+    static_assert(I < sizeof...(T), "Index out of range");
+    using type = __type_pack_element<I, T...>;
+};
+
+#else
+
+template <template <typename...> typename L, typename... T, std::size_t I>
+struct mp_at_c_impl<L<T...>, I>
+{
+    static_assert(I < sizeof...(T), "Index out of range");
+    using type = typename decltype(mp_select_indexed<I>(
+        mp_indexer<std::index_sequence_for<T...>, T...>{}))::type;
+};
+
+#endif
+
+template <typename L, std::size_t I>
+using mp_at_c = typename mp_at_c_impl<L, I>::type;
+
+template <typename L, typename I>
+using mp_at = mp_at_c<L, I::value>;
+
+// Find: index of the first V in L, mp_size<L> if there is none
+template <typename L, typename V>
+struct mp_find_impl;
+
+#if defined(TYPE_LIST_NAIVE)
+
+template <template <typename...> typename L, typename V>
+struct mp_find_impl<L<>, V>
+{
+    using type = std::integral_constant<std::size_t, 0>;
+};
+
+template <template <typename...> typename L, typename T1, typename... T,
+          typename V>
+struct mp_find_impl<L<T1, T...>, V>
+{
+    using type = std::integral_constant<std::size_t,
+        std::is_same_v<T1, V> ? 0
+                              : 1 + mp_find_impl<L<T...>, V>::type::value>;
+};
+
+#else
+
+template <template <typename...> typename L, typename... T, typename V>
+struct mp_find_impl<L<T...>, V>
+{
+    static constexpr std::size_t find()
+    {
+        std::size_t i = 0;
+        static_cast<void>(((std::is_same_v<T, V> || (++i, false)) || ...));
+        return i;
+    }
+
+    using type = std::integral_constant<std::size_t, find()>;
+};
+
+#endif
+
+template <typename L, typename V>
+using mp_find = typename mp_find_impl<L, V>::type;
+
+// Contains
+template <typename L, typename V>
+using mp_contains =
+    std::bool_constant<mp_find<L, V>::value != mp_size<L>::value>;
+
+// Select: L<mp_at_c<L, Set.index[0]>, ..., mp_at_c<L, Set.index[size - 1]>>
+template <std::size_t N>
+struct mp_index_set
+{
+    std::size_t index[N > 0 ? N : 1] = {};
+    std::size_t size = 0;
+};
+
+// Positions of the entries of flags which are equal to value.
+template <typename F, std::size_t N>
+constexpr mp_index_set<N> mp_where(const std::array<F, N>& flags, F value)
+{
+    mp_index_set<N> set;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        if (flags[i] == value)
+        {
+            set.index[set.size++] = i;
+        }
+    }
+    return set;
+}
+
+template <typename L, auto Set, typename S = std::make_index_sequence<Set.size>>
+struct mp_select_impl;
+
+#if defined(MP_HAS_TYPE_PACK_ELEMENT)
+
+template <template <typename...> typename L, typename... T, auto Set,
+          std::size_t... J>
+struct mp_select_impl<L<T...>, Set, std::index_sequence<J...>>
+{
+    using type = L<__type_pack_element<Set.index[J], T...>...>;
+};
+
+#else
+
+// The indexer is built once per list; going through mp_at_c would match
+// the whole list again for every selected element.
+template <template <typename...> typename L, typename... T, auto Set,
+          std::size_t... J>
+struct mp_select_impl<L<T...>, Set, std::index_sequence<J...>>
+{
+    using indexer = mp_indexer<std::index_sequence_for<T...>, T...>;
+    using type =
+        L<typename decltype(mp_select_indexed<Set.index[J]>(indexer{}))::type...>;
+};
+
+#endif
+
+template <typename L, auto Set>
+using mp_select = typename mp_select_impl<L, Set>::type;
+
+// Take/drop the elements in [First, Last)
+template <std::size_t First, std::size_t Last>
+constexpr mp_index_set<Last - First> mp_range()
+{
+    mp_index_set<Last - First> set;
+    for (std::size_t i = First; i < Last; ++i)
+    {
+        set.index[set.size++] = i;
+    }
+    return set;
+}
+
+template <typename L, std::size_t First, std::size_t Last>
+using mp_slice = mp_select<L, mp_range<First, Last>()>;
+
+// The first N elements / all but the first N elements
+template <typename L, std::size_t N>
+using mp_take_c = mp_slice<L, 0, N>;
+
+template <typename L, std::size_t N>
+using mp_drop_c = mp_slice<L, N, mp_size<L>::value>;
+
+// Unique: keeps the first occurrence of every type
+template <typename... T>
+struct mp_inherit : mp_identity<T>...
+{
+};
+
+template <typename L>
+struct mp_unique_impl;
+
+template <template <typename...> typename L>
+struct mp_unique_impl<L<>>
+{
+    using type = L<>;
+};
+
+template <template <typename...> typename L, typename T>
+struct mp_unique_impl<L<T>>
+{
+    using type = L<T>;
+};
+
+// Both halves are made unique, then the elements of the right half
+// which are in the left one are dropped. A class can inherit from the
+// elements of a duplicate free list, so the lookup is a single
+// is_base_of. Depth O(log N), no pairwise comparison of types.
+template <template <typename...> typename L, typename... T>
+struct mp_unique_impl<L<T...>>
+{
+    static constexpr std::size_t mid = sizeof...(T) / 2;
+
+    template <typename Left, typename Right>
+    struct merge;
+
+    template <typename... U, typename... V>
+    struct merge<L<U...>, L<V...>>
+    {
+        static constexpr std::array<bool, sizeof...(V)> fresh = {
+            !std::is_base_of_v<mp_identity<V>, mp_inherit<U...>>...};
+
+        using type = mp_append<L<U...>, mp_select<L<V...>, mp_where(fresh, true)>>;
+    };
+
+    using type = typename merge<
+        typename mp_unique_impl<mp_slice<L<T...>, 0, mid>>::type,
+        typename mp_unique_impl<mp_slice<L<T...>, mid, sizeof...(T)>>::type>::type;
+};
+
+template <typename L>
+using mp_unique = typename mp_unique_impl<L>::type;
+
+// Partition: mp_list<L<T for which P<T>::value>, L<all others>>
+template <typename L, template <typename...> typename P>
+struct mp_partition_impl;
+
+template <template <typename...> typename L, typename... T,
+          template <typename...> typename P>
+struct mp_partition_impl<L<T...>, P>
+{
+    static constexpr std::array<bool, sizeof...(T)> flags = {
+        static_cast<bool>(P<T>::value)...};
+
+    using type = mp_list<mp_select<L<T...>, mp_where(flags, true)>,
+        mp_select<L<T...>, mp_where(flags, false)>>;
+};
+
+template <typename L, template <typename...> typename P>
+using mp_partition = typename mp_partition_impl<L, P>::type;
+
+// Sort: stable, P<A, B>::value is true if A is ordered before B
+template <typename L, template <typename...> typename P>
+struct mp_sort_impl;
+
+template <template <typename...> typename L, template <typename...> typename P>
+struct mp_sort_impl<L<>, P>
+{
+    using type = L<>;
+};
+
+template <template <typename...> typename L, typename T,
+          template <typename...> typename P>
+struct mp_sort_impl<L<T>, P>
+{
+    using type = L<T>;
+};
+
+// Order of the merged list: the element at left[i] goes to i plus the
+// number of right elements before it, the one at right[j] to j plus
+// the number of left elements before it.
+template <std::size_t M, std::size_t N>
+constexpr mp_index_set<M + N> mp_merge_order(
+    const std::array<std::size_t, M>& left, const std::array<std::size_t, N>& right)
+{
+    mp_index_set<M + N> set;
+    for (std::size_t i = 0; i < M; ++i)
+    {
+        set.index[i + left[i]] = i;
+    }
+    for (std::size_t j = 0; j < N; ++j)
+    {
+        set.index[j + right[j]] = M + j;
+    }
+    set.size = M + N;
+    return set;
+}
+
+// Merges two sorted lists in a single mp_select instead of a recursion
+// over the elements. Equal elements of the left list go first, which
+// makes the sort stable.
+template <typename Left, typename Right, template <typename...> typename P>
+struct mp_merge_impl;
+
+template <template <typename...> typename L, typename... U, typename... V,
+          template <typename...> typename P>
+struct mp_merge_impl<L<U...>, L<V...>, P>
+{
+    template <typename X>
+    static constexpr std::size_t rightBefore =
+        (std::size_t{0} + ... + std::size_t{P<V, X>::value});
+
+    template <typename Y>
+    static constexpr std::size_t leftBefore =
+        (std::size_t{0} + ... + std::size_t{!P<Y, U>::value});
+
+    static constexpr std::array<std::size_t, sizeof...(U)> left = {
+        rightBefore<U>...};
+    static constexpr std::array<std::size_t, sizeof...(V)> right = {
+        leftBefore<V>...};
+
+    using type = mp_select<L<U..., V...>, mp_merge_order(left, right)>;
+};
+
+// Merge sort: every level halves the list, so the depth is O(log N)
+// for every input.
+template <template <typename...> typename L, typename... T,
+          template <typename...> typename P>
+struct mp_sort_impl<L<T...>, P>
+{
+    static constexpr std::size_t mid = sizeof...(T) / 2;
+
+    using type = typename mp_merge_impl<
+        typename mp_sort_impl<mp_take_c<L<T...>, mid>, P>::type,
+        typename mp_sort_impl<mp_drop_c<L<T...>, mid>, P>::type, P>::type;
+};
+
+template <typename L, template <typename...> typename P>
+using mp_sort = typename mp_sort_impl<L, P>::type;
+
+// Less for integral constants
+template <typename A, typename B>
+using mp_less = std::bool_constant<(A::value < B::value)>;
+
+template <typename A, typename B>
+using size_less = std::bool_constant<(sizeof(A) < sizeof(B))>;
+
+// Jump table: one function pointer per type of a list, indexed by the
+// position of the type. Calling through it is a single indirect call,
+// std::visit may go through several layers of indirection.
+template <typename Storage, typename T>
+using copy_const = std::conditional_t<std::is_const_v<Storage>, const T, T>;
+
+template <typename R, typename F, typename T, typename Storage>
+R jump_table_call(F& f, Storage* storage)
+{
+    return f(*static_cast<copy_const<Storage, T>*>(storage));
+}
+
+template <typename... T>
+struct jump_table
+{
+    template <typename R, typename F, typename Storage>
+    static constexpr R (*entries[])(F&, Storage*) = {
+        &jump_table_call<R, F, T, Storage>...};
+};
+
+// Smallest unsigned type which can hold the index of every type.
+template <std::size_t N>
+using tag_type = std::conditional_t<N <= 0xff, std::uint8_t,
+    std::conditional_t<N <= 0xffff, std::uint16_t, std::uint32_t>>;
+
+// Tagged union of the types of a list. The storage is sized and aligned
+// for the largest member and the tag is the smallest type which fits.
+// All operations which depend on the active member go through
+// jump_table.
+template <typename L>
+class tagged_union;
+
+template <typename... T>
+class tagged_union<mp_list<T...>>
+{
+public:
+    using types = mp_list<T...>;
+    using tag = tag_type<sizeof...(T)>;
+
+    static_assert(sizeof...(T) > 0, "A tagged union needs a type");
+    static_assert(std::is_same<mp_unique<types>, types>::value,
+        "The types of a tagged union have to be unique");
+    static_assert((std::is_nothrow_move_constructible_v<T> && ...),
+        "Assignment relies on nothrow move construction");
+
+    tagged_union()
+        : tagged_union(std::in_place_type<mp_front<types>>)
+    {
+    }
+
+    template <typename U, typename... Args>
+    explicit tagged_union(std::in_place_type_t<U>, Args&&... args)
+        : m_tag{static_cast<tag>(mp_find<types, U>::value)}
+    {
+        static_assert(mp_contains<types, U>::value, "Not a member type");
+        ::new (static_cast<void*>(m_storage)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U,
+              typename = std::enable_if_t<
+                  mp_contains<types, std::remove_cvref_t<U>>::value>>
+    tagged_union(U&& value)
+        : tagged_union(std::in_place_type<std::remove_cvref_t<U>>,
+            std::forward<U>(value))
+    {
+    }
+
+    tagged_union(const tagged_union& other)
+        : m_tag{other.m_tag}
+    {
+        other.dispatch([this](const auto& value) {
+            ::new (static_cast<void*>(m_storage))
+                std::remove_cvref_t<decltype(value)>(value);
+        });
+    }
+
+    tagged_union(tagged_union&& other) noexcept
+        : m_tag{other.m_tag}
+    {
+        other.dispatch([this](auto& value) {
+            ::new (static_cast<void*>(m_storage))
+                std::remove_cvref_t<decltype(value)>(std::move(value));
+        });
+    }
+
+    tagged_union& operator=(const tagged_union& other)
+    {
+        if (this != &other)
+        {
+            tagged_union copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    tagged_union& operator=(tagged_union&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_tag = other.m_tag;
+            other.dispatch([this](auto& value) {
+                ::new (static_cast<void*>(m_storage))
+                    std::remove_cvref_t<decltype(value)>(std::move(value));
+            });
+        }
+        return *this;
+    }
+
+    ~tagged_union()
+    {
+        destroy();
+    }
+
+    std::size_t index() const noexcept
+    {
+        return m_tag;
+    }
+
+    template <typename U>
+    U* get_if() noexcept
+    {
+        return m_tag == mp_find<types, U>::value ?
+                   std::launder(reinterpret_cast<U*>(m_storage)) :
+                   nullptr;
+    }
+
+    // Calls f with the active member. All overloads of f have to return
+    // the same type.
+    template <typename F>
+    decltype(auto) dispatch(F&& f)
+    {
+        using R = std::invoke_result_t<F&, mp_front<types>&>;
+        return jump_table<T...>::template entries<R, F, void>[m_tag](
+            f, static_cast<void*>(m_storage));
+    }
+
+    template <typename F>
+    decltype(auto) dispatch(F&& f) const
+    {
+        using R = std::invoke_result_t<F&, const mp_front<types>&>;
+        return jump_table<T...>::template entries<R, F, const void>[m_tag](
+            f, static_cast<const void*>(m_storage));
+    }
+
+private:
+    void destroy() noexcept
+    {
+        dispatch([](auto& value) { std::destroy_at(&value); });
+    }
+
+    static constexpr std::size_t s_size = std::max({sizeof(T)...});
+    static constexpr std::size_t s_align = std::max({alignof(T)...});
+
+    alignas(s_align) std::byte m_storage[s_size];
+    tag m_tag;
+};
+
+// Random access iterator over several columns at once. Like
+// matrix_iterator in CustomView.cpp it is a proxy iterator: the
+// reference is a tuple of references into the columns.
+template <typename... U>
+struct soa_iterator
+    : boost::stl_interfaces::proxy_iterator_interface<soa_iterator<U...>,
+          std::random_access_iterator_tag, std::tuple<U&...>>
+{
+    constexpr soa_iterator() noexcept = default;
+
+    constexpr soa_iterator(std::tuple<U*...> columns, std::ptrdiff_t index) noexcept
+        : m_columns{columns}
+        , m_index{index}
+    {
+    }
+
+    std::tuple<U&...> operator*() const noexcept
+    {
+        return std::apply(
+            [this](U*... column) { return std::tuple<U&...>{column[m_index]...}; },
+            m_columns);
+    }
+    constexpr soa_iterator& operator+=(std::ptrdiff_t i) noexcept
+    {
+        m_index += i;
+        return *this;
+    }
+    constexpr auto operator-(soa_iterator other) const noexcept
+    {
+        return m_index - other.m_index;
+    }
+
+private:
+    std::tuple<U*...> m_columns{};
+    std::ptrdiff_t m_index = 0;
+};
+
+template <typename... U>
+struct soa_zip_view : public std::ranges::view_interface<soa_zip_view<U...>>
+{
+    soa_zip_view() = default;
+
+    soa_zip_view(std::tuple<U*...> columns, std::size_t size)
+        : m_columns{columns}
+        , m_size{size}
+    {
+    }
+
+    auto begin() const
+    {
+        return soa_iterator<U...>{m_columns, 0};
+    }
+    auto end() const
+    {
+        return soa_iterator<U...>{
+            m_columns, static_cast<std::ptrdiff_t>(m_size)};
+    }
+
+private:
+    std::tuple<U*...> m_columns{};
+    std::size_t m_size = 0;
+};
+
+// Structure of arrays: every type of the list is stored in its own
+// contiguous column. Elements are accessed as tuples of references, a
+// pass over a subset of the members only reads those columns, e.g.
+//
+//   soa_vector<mp_list<float, float, int>> v;
+//   for (auto [x, id] : v.zip<0, 2>()) ...
+//   std::span<float> xs = v.column<0>();
+template <typename L>
+class soa_vector;
+
+template <typename... T>
+class soa_vector<mp_list<T...>>
+{
+public:
+    using types = mp_list<T...>;
+    using value_type = std::tuple<T...>;
+    using reference = std::tuple<T&...>;
+    using const_reference = std::tuple<const T&...>;
+    using iterator = soa_iterator<T...>;
+    using const_iterator = soa_iterator<const T...>;
+
+    template <std::size_t I>
+    using column_type = mp_at_c<types, I>;
+
+    void push_back(T... values)
+    {
+        push_back_impl(std::index_sequence_for<T...>{}, std::move(values)...);
+    }
+
+    void push_back(value_type value)
+    {
+        std::apply(
+            [this](T&... values) { push_back(std::move(values)...); }, value);
+    }
+
+    void reserve(std::size_t n)
+    {
+        std::apply([n](auto&... column) { (column.reserve(n), ...); },
+            m_columns);
+    }
+
+    void clear() noexcept
+    {
+        std::apply([](auto&... column) { (column.clear(), ...); }, m_columns);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return std::get<0>(m_columns).size();
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    reference operator[](std::size_t i) noexcept
+    {
+        return begin()[static_cast<std::ptrdiff_t>(i)];
+    }
+
+    const_reference operator[](std::size_t i) const noexcept
+    {
+        return begin()[static_cast<std::ptrdiff_t>(i)];
+    }
+
+    template <std::size_t I>
+    std::span<column_type<I>> column() noexcept
+    {
+        return std::get<I>(m_columns);
+    }
+
+    template <std::size_t I>
+    std::span<const column_type<I>> column() const noexcept
+    {
+        return std::get<I>(m_columns);
+    }
+
+    // Column by type, only if the type occurs once.
+    template <typename U>
+    std::span<U> column() noexcept
+    {
+        static_assert((std::is_same_v<T, U> + ...) == 1,
+            "The type has to occur exactly once, use column<I>");
+        return column<mp_find<types, U>::value>();
+    }
+
+    // Iterates the columns I... together.
+    template <std::size_t... I>
+    soa_zip_view<column_type<I>...> zip() noexcept
+    {
+        return {std::tuple<column_type<I>*...>{std::get<I>(m_columns).data()...},
+            size()};
+    }
+
+    template <std::size_t... I>
+    soa_zip_view<const column_type<I>...> zip() const noexcept
+    {
+        return {std::tuple<const column_type<I>*...>{
+                    std::get<I>(m_columns).data()...},
+            size()};
+    }
+
+    iterator begin() noexcept
+    {
+        return all(std::index_sequence_for<T...>{}).begin();
+    }
+    iterator end() noexcept
+    {
+        return all(std::index_sequence_for<T...>{}).end();
+    }
+    const_iterator begin() const noexcept
+    {
+        return all(std::index_sequence_for<T...>{}).begin();
+    }
+    const_iterator end() const noexcept
+    {
+        return all(std::index_sequence_for<T...>{}).end();
+    }
+
+private:
+    template <std::size_t... I>
+    void push_back_impl(std::index_sequence<I...>, T&&... values)
+    {
+        (std::get<I>(m_columns).push_back(std::move(values)), ...);
+    }
+
+    template <std::size_t... I>
+    auto all(std::index_sequence<I...>) noexcept
+    {
+        return zip<I...>();
+    }
+
+    template <std::size_t... I>
+    auto all(std::index_sequence<I...>) const noexcept
+    {
+        return zip<I...>();
+    }
+
+    template <typename U>
+    using column_storage = std::vector<U>;
+
+    mp_rename<mp_transform<column_storage, types>, std::tuple> m_columns;
+};
+
+#if defined(TYPE_LIST_BENCHMARK)
+#if !defined(TYPE_LIST_BENCHMARK_SIZE)
+#define TYPE_LIST_BENCHMARK_SIZE 500
+#endif
+
+namespace benchmark
+{
+constexpr std::size_t N = TYPE_LIST_BENCHMARK_SIZE;
+
+template <std::size_t... I>
+mp_list<std::integral_constant<std::size_t, N - 1 - I>...> reversed_fn(
+    std::index_sequence<I...>);
+
+using iota = mp_iota_c<N>;
+using reversed = decltype(reversed_fn(std::make_index_sequence<N>{}));
+using last = std::integral_constant<std::size_t, N - 1>;
+
+static_assert(std::is_same<mp_at_c<iota, N - 1>, last>::value, "Not equal");
+static_assert(mp_find<iota, last>::value == N - 1, "Not equal");
+static_assert(mp_contains<reversed, last>::value, "Not equal");
+
+#if !defined(TYPE_LIST_NAIVE)
+static_assert(
+    std::is_same<mp_unique<mp_append<mp_iota_c<N / 2>, mp_iota_c<N - N / 2>>>,
+        mp_iota_c<N - N / 2>>::value,
+    "Not equal");
+template <typename T>
+using is_odd = std::bool_constant<T::value % 2 == 1>;
+static_assert(mp_size<mp_front<mp_partition<iota, is_odd>>>::value == N / 2,
+    "Not equal");
+static_assert(std::is_same<mp_sort<reversed, mp_less>, iota>::value,
+    "Not equal");
+
+// Every middle element is the smallest of the elements left: a
+// quicksort around the middle element would need N levels here.
+constexpr std::array<std::size_t, N> middle_smallest()
+{
+    std::array<std::size_t, N> slots{};
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        slots[i] = i;
+    }
+    std::array<std::size_t, N> values{};
+    for (std::size_t k = 0, remaining = N; k < N; ++k, --remaining)
+    {
+        const auto mid = remaining / 2;
+        values[slots[mid]] = k;
+        for (auto i = mid; i + 1 < remaining; ++i)
+        {
+            slots[i] = slots[i + 1];
+        }
+    }
+    return values;
+}
+
+template <std::size_t... I>
+mp_list<std::integral_constant<std::size_t, middle_smallest()[I]>...>
+    middle_smallest_fn(std::index_sequence<I...>);
+
+using adversarial =
+    decltype(middle_smallest_fn(std::make_index_sequence<N>{}));
+
+static_assert(std::is_same<mp_sort<adversarial, mp_less>, iota>::value,
+    "Not equal");
+#endif
+} // namespace benchmark
+#endif
+
+// Messages for the dispatch benchmark
+struct ping
+{
+    int id;
+};
+
+struct move_to
+{
+    float x;
+    float y;
+    float z;
+};
+
+struct chat
+{
+    std::string text;
+};
+
+struct shutdown
+{
+};
+
+using messages = mp_list<ping, move_to, chat, shutdown>;
+
+struct message_handler
+{
+    std::size_t sum = 0;
+
+    void operator()(const ping& m)
+    {
+        sum += static_cast<std::size_t>(m.id);
+    }
+    void operator()(const move_to& m)
+    {
+        sum += static_cast<std::size_t>(m.x + m.y + m.z);
+    }
+    void operator()(const chat& m)
+    {
+        sum += m.text.size();
+    }
+    void operator()(const shutdown&)
+    {
+        ++sum;
+    }
+};
+
+template <typename Message, typename Dispatch>
+void benchmark_dispatch(const char* name, std::size_t count, Dispatch dispatch)
+{
+    std::vector<Message> queue;
+    queue.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        switch (i * 7 % 4)
+        {
+        case 0:
+            queue.emplace_back(ping{static_cast<int>(i)});
+            break;
+        case 1:
+            queue.emplace_back(move_to{1.0f, 2.0f, 3.0f});
+            break;
+        case 2:
+            queue.emplace_back(chat{"hello"});
+            break;
+        default:
+            queue.emplace_back(shutdown{});
+        }
+    }
+
+    message_handler handler;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& message : queue)
+    {
+        dispatch(message, handler);
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() << " ms, " << sizeof(Message)
+              << " bytes per message (" << handler.sum << ")" << std::endl;
+}
+
+// Records for the structure of arrays benchmark
+struct body
+{
+    float x;
+    float y;
+    float z;
+    int id;
+    double mass;
+    char name[16];
+};
+
+using body_fields = mp_list<float, float, float, int, double, std::array<char, 16>>;
+
+void benchmark_soa(std::size_t count)
+{
+    std::vector<body> aos(count);
+    soa_vector<body_fields> soa;
+    soa.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto mass = static_cast<double>(i % 100);
+        aos[i].mass = mass;
+        soa.push_back(0.0f, 0.0f, 0.0f, static_cast<int>(i), mass, {});
+    }
+
+    const auto measure = [](const char* name, auto f) {
+        const auto start = std::chrono::steady_clock::now();
+        const double result = f();
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << elapsed.count() << " ms (" << result << ")"
+                  << std::endl;
+    };
+    measure("mass AoS", [&] {
+        double sum = 0;
+        for (const auto& b : aos)
+        {
+            sum += b.mass;
+        }
+        return sum;
+    });
+    measure("mass SoA", [&] {
+        double sum = 0;
+        for (auto mass : soa.column<4>())
+        {
+            sum += mass;
+        }
+        return sum;
+    });
+}
+
 int main(int argc, char* argv[])
 {
 
@@ -176,6 +1152,90 @@ int main(int argc, char* argv[])
         std::is_same<mp_rename<std::tuple<int, double>, std::pair>,
         std::pair<int, double>>::value == true, "Not equal");
 
+    static_assert(
+        std::is_same<mp_at_c<std::tuple<int, double, char>, 1>, double>::value == true,
+        "Not equal");
+
+    static_assert(
+        std::is_same<mp_at<std::tuple<int, double, char>,
+                         std::integral_constant<std::size_t, 2>>,
+            char>::value == true,
+        "Not equal");
+
+    static_assert(mp_find<std::tuple<int, double, char>, char>::value == 2, "Not equal");
+
+    static_assert(mp_find<std::tuple<int, double>, char>::value == 2, "Not equal");
+
+    static_assert(mp_contains<std::tuple<int, double>, double>::value == true, "Not equal");
+
+    static_assert(mp_contains<std::tuple<int, double>, char>::value == false, "Not equal");
+
+    static_assert(
+        std::is_same<mp_append<std::tuple<int>, std::tuple<>, std::tuple<char, int>>,
+            std::tuple<int, char, int>>::value == true,
+        "Not equal");
+
+    static_assert(
+        std::is_same<mp_unique<std::tuple<int, double, int, char, double>>,
+            std::tuple<int, double, char>>::value == true,
+        "Not equal");
+
+    static_assert(
+        std::is_same<mp_partition<std::tuple<int, double, char, float>,
+                         std::is_floating_point>,
+            mp_list<std::tuple<double, float>, std::tuple<int, char>>>::value == true,
+        "Not equal");
+
+    using unsorted = mp_list<std::integral_constant<int, 3>,
+        std::integral_constant<int, 1>, std::integral_constant<int, 2>,
+        std::integral_constant<int, 1>, std::integral_constant<int, 0>>;
+    static_assert(
+        std::is_same<mp_sort<unsorted, mp_less>,
+            mp_list<std::integral_constant<int, 0>, std::integral_constant<int, 1>,
+                std::integral_constant<int, 1>, std::integral_constant<int, 2>,
+                std::integral_constant<int, 3>>>::value == true,
+        "Not equal");
+
+    // Sorting by size is stable: int and float keep their order.
+    static_assert(
+        std::is_same<mp_sort<std::tuple<double, int, char, float>, size_less>,
+            std::tuple<char, int, float, double>>::value == true,
+        "Not equal");
+
+    static_assert(sizeof(tagged_union<mp_list<char, std::array<char, 2>>>) == 3,
+        "Not equal");
+
+    tagged_union<messages> message{chat{"hello"}};
+    message = move_to{1.0f, 2.0f, 3.0f};
+    auto copy = message;
+    std::cout << "index " << copy.index() << ", x " << copy.get_if<move_to>()->x
+              << std::endl;
+
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    benchmark_dispatch<mp_rename<messages, std::variant>>("std::visit", count,
+        [](const auto& m, auto& handler) { std::visit(handler, m); });
+    benchmark_dispatch<tagged_union<messages>>("jump table", count,
+        [](const auto& m, auto& handler) { m.dispatch(handler); });
+
+    soa_vector<mp_list<float, float, int>> points;
+    points.reserve(3);
+    points.push_back(1.0f, 2.0f, 1);
+    points.push_back(3.0f, 4.0f, 2);
+    points.push_back({5.0f, 6.0f, 3});
+    static_assert(std::ranges::random_access_range<decltype(points.zip<0, 1>())>);
+    for (auto [x, y] : points.zip<0, 1>())
+    {
+        x += y;
+    }
+    for (auto [x, y, id] : points)
+    {
+        std::cout << id << ": " << x << " " << y << std::endl;
+    }
+    std::cout << "ids " << points.column<int>().size() << ", first x "
+              << std::get<0>(points[0]) << std::endl;
+
+    benchmark_soa(count);
+
     return 0;
 }
 